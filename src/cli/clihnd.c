@@ -50,7 +50,17 @@
 #if TRANSIT_VERIPHY
 #include "veriphy.h"
 #endif
+#include "phytsk.h"
 #include "h2stats.h"
+#include "h2txrx.h"
+#include "h2txrxaux.h"
+#include "h2mactab.h"
+#if TRANSIT_IGMP_SNOOP
+#include "h2igmp.h"
+#endif
+#if TRANSIT_BUF_PROFILE
+#include "h2bufcfg.h"
+#endif
 
 #ifndef NO_DEBUG_IF
 
@@ -124,6 +134,34 @@ static void cmd_print_lldp_remoteinfo (void);
 #endif
 #if TRANSIT_VERIPHY
 static void cmd_run_veriphy(uchar port_no);
+static void cmd_print_veriphy(void);
+#endif
+#ifndef UNMANAGED_REDUCED_DEBUG_IF
+static void cmd_print_rx_class_cnt(void);
+static void cmd_print_phy_health(void);
+#if TRANSIT_CPU_POLICING
+static void cmd_print_cpu_pol(void);
+#endif
+static void cmd_print_mactab(void);
+#if TRANSIT_MACTAB_STAT
+static void cmd_print_mactab_stat(void);
+#endif
+#if TRANSIT_LEARN_LIMIT
+static void cmd_print_learn_limit(void);
+#endif
+#if TRANSIT_AGE_ADAPT
+static void cmd_print_age_adapt(void);
+#endif
+#if TRANSIT_PORT_RATE
+static void cmd_print_port_rate(void);
+#endif
+#if TRANSIT_DROP_STAT
+static void cmd_print_drop_stat(void);
+#endif
+#if TRANSIT_IGMP_SNOOP
+static void cmd_print_igmp(void);
+static void cmd_print_port_list(port_bit_mask_t mask);
+#endif
 #endif
 
 /*****************************************************************************
@@ -431,6 +469,7 @@ static uchar handle_command (void)
 #ifndef UNMANAGED_REDUCED_DEBUG_IF
 #if LOOPBACK_TEST
         println_str("T : Loopback test");
+        println_str("T 3 <port> <length> [count]: CPU tx/rx benchmark");
 #endif
 #if TRANSIT_LLDP
 #if TRANSIT_EEE_LLDP
@@ -447,7 +486,7 @@ static uchar handle_command (void)
         println_str("B level: Set debug level 1 to 4");
 #endif
 #if UNMANAGED_TRANSIT_VERIPHY_DEBUG_IF
-        println_str("C [port_no|0xff] : run veriphy");
+        println_str("C [port_no|0xff] : run veriphy, C without port shows the last result");
 #endif
 #if TRANSIT_EEE
         println_str("A [0|1|2]: 1=EEE mode rev_b (max savings), 2=EEE mode rev_a (less power savings), 0=EEE Disabled");
@@ -460,6 +499,32 @@ static uchar handle_command (void)
 #endif
 #if USE_HW_TWI
         println_str("C : read I2C data <I2C_addr> <starting addr> <count>");
+#endif
+        println_str("P [0] : Show CPU rx frame and ring counters, P 0 clears them");
+        println_str("E [0] : Show PHY MIIM errors and SerDes sync losses per port, E 0 clears them");
+#if TRANSIT_MACTAB_STAT
+        println_str("M [1] : Show MAC table statistics of the last scan and start a new one, M 1 lists the entries");
+#else
+        println_str("M : List the MAC table entries");
+#endif
+#if TRANSIT_LEARN_LIMIT
+        println_str("N [port_no limit] : Show learn limits, set port limit to 2**limit entries (13: none)");
+        println_str("N 0 [drop] : Clear learn statistics, or set action over limit (0: forward, 1: drop)");
+#endif
+#if TRANSIT_AGE_ADAPT
+        println_str("K : Show adaptive MAC ageing state");
+#endif
+#if TRANSIT_PORT_RATE
+        println_str("J [0] : Show average and peak port rates, J 0 clears the peaks");
+#endif
+#if TRANSIT_DROP_STAT
+        println_str("Y [0] : Show drop rates, buffer use and congestion events, Y 0 clears peaks and events");
+#endif
+#if TRANSIT_IGMP_SNOOP
+        println_str("U [0] : Show IGMP groups, router ports and counters, U 0 clears the counters");
+#endif
+#if TRANSIT_CPU_POLICING
+        println_str("Q [0|pol fps] : Show CPU policers, 0 clears drops, set pol (0=UC 1=BC 2=MC 3=Learn) to fps");
 #endif
         println_str("S : Suspend/Resume applications");
 #if LUTON_UNMANAGED_SWUP
@@ -469,6 +534,9 @@ static uchar handle_command (void)
 #if LUTON_UNMANAGED_CONF_IF
         println_str("CONFIG                       : Show all configurations");
         println_str("CONFIG MAC xx:xx:xx:xx:xx:xx : Update MAC addresses in RAM");
+#if TRANSIT_BUF_PROFILE
+        println_str("CONFIG BUF n                 : Select buffer profile n (0=balanced 1=burst 2=low-latency 3=jumbo)");
+#endif
         println_str("CONFIG SAVE                  : Program configurations at RAM to flash");
 #endif
         break;
@@ -483,6 +551,12 @@ static uchar handle_command (void)
         case 2:
             perform_tx_rx_test(parms[1], parms[2], 1);
             break;
+        case 3:
+            if (parms_no < 3 || parms[2] < BENCH_LENGTH_MIN || parms[2] > BENCH_LENGTH_MAX) {
+                return FORMAT_ERROR;
+            }
+            perform_tx_rx_bench(parms[1], (ushort) parms[2], parms_no > 3 ? (ushort) parms[3] : 1000);
+            break;
 #endif /* LOOPBACK_TEST */
 
         default:
@@ -752,9 +826,105 @@ static uchar handle_command (void)
 
 #if UNMANAGED_TRANSIT_VERIPHY_DEBUG_IF
     case 'C':
-        cmd_run_veriphy((uchar) parms[0]);
+        if (parms_no == 0) {
+            cmd_print_veriphy();
+        } else {
+            cmd_run_veriphy((uchar) parms[0]);
+        }
         break;
 #endif
+    case 'P': /* CPU rx frame counters */
+        if (parms_no == 1 && parms[0] == 0) {
+            h2_rx_class_cnt_clear();
+#if TRANSIT_LLDP || LOOPBACK_TEST || TRANSIT_VERIPHY
+            h2_rx_ring_stat_clear();
+#endif
+        } else {
+            cmd_print_rx_class_cnt();
+        }
+        break;
+
+    case 'E': /* PHY health check counters */
+        if (parms_no == 1 && parms[0] == 0) {
+            phy_health_cnt_clear();
+        } else {
+            cmd_print_phy_health();
+        }
+        break;
+
+    case 'M': /* MAC table */
+#if TRANSIT_MACTAB_STAT
+        if (parms_no == 0) {
+            cmd_print_mactab_stat();
+            h2_mactab_scan_start();
+            break;
+        }
+#endif
+        cmd_print_mactab();
+        break;
+
+#if TRANSIT_LEARN_LIMIT
+    case 'N': /* MAC learn limits */
+        if (parms_no == 2 && parms[0] == 0) {
+            h2_mactab_learn_drop_set(parms[1] != 0);
+        } else if (parms_no == 2) {
+            h2_mactab_learn_limit_set(port2int((uchar) parms[0]), (uchar) parms[1]);
+        } else if (parms_no == 1 && parms[0] == 0) {
+            h2_mactab_learn_stat_clear();
+        } else {
+            cmd_print_learn_limit();
+        }
+        break;
+#endif
+
+#if TRANSIT_AGE_ADAPT
+    case 'K': /* Adaptive MAC ageing */
+        cmd_print_age_adapt();
+        break;
+#endif
+
+#if TRANSIT_PORT_RATE
+    case 'J': /* Port rates */
+        if (parms_no == 1 && parms[0] == 0) {
+            h2_stats_rate_peak_clear();
+        } else {
+            cmd_print_port_rate();
+        }
+        break;
+#endif
+
+#if TRANSIT_DROP_STAT
+    case 'Y': /* Drop statistics */
+        if (parms_no == 1 && parms[0] == 0) {
+            h2_stats_drop_clear();
+        } else {
+            cmd_print_drop_stat();
+        }
+        break;
+#endif
+
+#if TRANSIT_IGMP_SNOOP
+    case 'U': /* IGMP snooping */
+        if (parms_no == 1 && parms[0] == 0) {
+            h2_igmp_cnt_clear();
+        } else {
+            cmd_print_igmp();
+        }
+        break;
+#endif
+
+#if TRANSIT_CPU_POLICING
+    case 'Q': /* CPU policers */
+        if (parms_no == 2) {
+            h2_cpu_pol_set((uchar) parms[0], parms[1]);
+        } else if (parms_no == 1 && parms[0] == 0) {
+            h2_cpu_pol_drop_clear();
+        } else {
+            cmd_print_cpu_pol();
+        }
+        break;
+#endif
+
     case 'S': /* Suspend/Resume applications */
         switch ((uchar) parms[0]) {
         case 0:
@@ -1036,13 +1206,7 @@ static void print_veriphy_status (uchar status)
 
 static void cmd_run_veriphy(uchar uport_no)
 {
-    uchar port_no;
-    uchar j;
-    uchar port_no_ext;
     port_bit_mask_t port_mask;
-    BOOL    done = FALSE;   
-    /* veriphy_parms_t xdata veriphy_parms [MAX_PORT]; */
-    veriphy_parms_t xdata *veriphy_parms = (veriphy_parms_t *) rx_packet;
 
     port_mask = 0;
     if(uport_no == 0xff) {
@@ -1051,91 +1215,430 @@ static void cmd_run_veriphy(uchar uport_no)
         WRITE_PORT_BIT_MASK(port2int(uport_no), 1, &port_mask);
     }
 
- 
-    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            veriphy_start(port_no); // Starting veriphy for selected port(s)
-        }
-    }
+    /* The result is collected by the PHY task, show it with 'C' */
+    phy_veriphy_start(port_mask);
+    println_str("VeriPHY started");
+}
 
-    // Pulling Verphy until Veriphy is done
-    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        phy_page_std(port_no);//read phy status register
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            done = FALSE;
-            while (!done) {			
-                veriphy_run(port_no, (veriphy_parms + port_no), &done);
-            }
-        }
-        else {//For Non-Test port, set link status as "OPEN"
-            veriphy_parms[port_no].loc[0]=0;
-            veriphy_parms[port_no].loc[1]=0;
-            veriphy_parms[port_no].loc[2]=0;
-            veriphy_parms[port_no].loc[3]=0;
-            veriphy_parms[port_no].stat[0]=1;
-            veriphy_parms[port_no].stat[1]=1;
-            veriphy_parms[port_no].stat[2]=1;
-            veriphy_parms[port_no].stat[3]=1;
-            veriphy_parms[port_no].flags=0;
-        }
+static void cmd_print_veriphy(void)
+{
+    uchar port_no;
+    uchar j;
+    uchar port_no_ext;
+    veriphy_parms_t xdata veriphy_parms;
+
+    if (phy_veriphy_busy()) {
+        println_str("VeriPHY running");
     }
 
     /* Print header */
     print_txt(TXT_NO_VERIPHY_STAT_HDR);
     for (port_no_ext = 1; port_no_ext < MAX_PORT; port_no_ext++) {
         port_no = port2int(port_no_ext);
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no) ) {
-            print_dec_16_right(port_no_ext, 2);
-            print_ch(':');
+        if (!phy_veriphy_result_get(port_no, &veriphy_parms)) {
+            continue;
+        }
+        print_dec_16_right(port_no_ext, 2);
+        print_ch(':');
+        print_spaces(3);
+        /* Valid */
+        if (veriphy_parms.flags) {
+            print_str("yes");
+        } else {
+            print_str("no ");
+        }
+        print_spaces(2);
+
+        /* Length or distance to fault for each pair */
+        for (j = 0; j < 4; j++) {
             print_spaces(3);
-            /* Valid */
-            if ((veriphy_parms+port_no)->flags) {
-                print_str("yes");
+            if (veriphy_parms.loc[j] != 0xff) {
+                print_dec_16_right(veriphy_parms.loc[j], 3);
             } else {
-                print_str("no ");
+                print_str("  -");
             }
+        }
+
+        /* Status for each pair */
+        for (j = 0; j < 4; j++) {
             print_spaces(2);
+            print_veriphy_status(veriphy_parms.stat[j]);
+        }
+        print_cr_lf();
+    }
+}
+#endif
 
-            /* Length or distance to fault for each pair */
-            for (j = 0; j < 4; j++) {
-                print_spaces(3);
+#ifndef UNMANAGED_REDUCED_DEBUG_IF
+static void cmd_print_rx_class_cnt(void)
+{
+    code char *class_txt[RX_CLASS_CNT + 3] = {
+        "LLDP:  ", "BPDU:  ", "Self:  ", "IPMC:  ", "Other: ", "Error: ", "Pruned:", "Longest:"
+    };
+    uchar cls;
 
-			 if ((veriphy_parms + port_no)->loc[j] != 0xff) {
-				 print_dec_16_right(veriphy_parms[port_no].loc[j], 3);
+    for (cls = 0; cls <= RX_CLASS_CNT + 2; cls++) {
+        print_str(class_txt[cls]);
+        print_dec(h2_rx_class_cnt_get(cls));
+        print_cr_lf();
+    }
+#if TRANSIT_LLDP || LOOPBACK_TEST || TRANSIT_VERIPHY
+    print_str("Ring stall:");
+    print_dec(h2_rx_ring_stall_get());
+    print_cr_lf();
+    print_str("Ring max:  ");
+    print_dec(h2_rx_ring_hwm_get());
+    print_str("/");
+    print_dec(RX_RING_CNT);
+    print_cr_lf();
+#endif
+}
 
-                } else {
-                    print_str("  -");
-                }
-            }
+static void cmd_print_phy_health(void)
+{
+    uchar port_ext;
+    uchar miim_err;
+    uchar sync_loss;
 
-            /* Status for each pair */
+    /* Counters saturate at 255 */
+    println_str("Port  MIIM err  Sync loss");
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        phy_health_cnt_get(port2int(port_ext), &miim_err, &sync_loss);
+        print_dec_nright(port_ext, 4);
+        print_dec_nright(miim_err, 10);
+        print_dec_nright(sync_loss, 11);
+        print_cr_lf();
+    }
+}
 
-            for (j = 0; j < 4; j++) {
-                print_spaces(2);
-                print_veriphy_status((veriphy_parms + port_no)->stat[j]);
-#if FRONT_LED_PRESENT
-                if((veriphy_parms+port_no)->stat[j]) {
-                    /* Set Error Leds */
-                    led_state_set(port_no_ext, VTSS_LED_EVENT_CABLE, VTSS_LED_MODE_BLINK_YELLOW);
-                }
+#if TRANSIT_CPU_POLICING
+static void cmd_print_cpu_pol(void)
+{
+    code char *pol_txt[CPU_POL_CNT] = {
+        "UC:    ", "BC:    ", "MC:    ", "Learn: "
+    };
+    uchar pol;
+    ulong fps;
+
+    for (pol = 0; pol < CPU_POL_CNT; pol++) {
+        print_str(pol_txt[pol]);
+        fps = h2_cpu_pol_get(pol);
+        if (fps) {
+            print_dec(fps);
+            print_str(" fps");
+        } else {
+            print_str("Disabled");
+        }
+        print_cr_lf();
+    }
+    print_str("Policed seconds: ");
+    print_dec(h2_cpu_pol_drop_get());
+    print_cr_lf();
+    print_str("CPU port drops:  ");
+    print_dec(h2_stats_counter_get(LUTON26_ICPU_PORT, CNT_TX_DROP) +
+              h2_stats_counter_get(LUTON26_ICPU_PORT, CNT_TX_AGED));
+    print_cr_lf();
+}
 #endif
+
+#define MACTAB_CLI_CHUNK    8
+
+static void cmd_print_mactab(void)
+{
+    mactab_cursor_t xdata cursor;
+    mactab_entry_t  xdata entries [MACTAB_CLI_CHUNK];
+    mactab_entry_t  xdata *entry;
+    uchar           cnt;
+    ushort          total = 0;
+
+    memset(&cursor, 0, sizeof(cursor));
+    println_str("VID   MAC                Port  Flags");
+    do {
+        cnt = h2_mactab_get_next(&cursor, entries, MACTAB_CLI_CHUNK);
+        for (entry = entries; entry < &entries[cnt]; entry++) {
+            print_dec_nright(entry->vid, 4);
+            print_spaces(2);
+            print_mac_addr(entry->mac);
+            print_spaces(2);
+            if (entry->flags & MACTAB_FLAG_MC) {
+                print_str("MC  ");
+            } else if (entry->pgid == LUTON26_ICPU_PORT) {
+                print_str("CPU ");
+            } else {
+                print_dec_nright(port2ext(entry->pgid), 4);
             }
+            print_spaces(2);
+            print_ch((entry->flags & MACTAB_FLAG_STATIC)   ? 'S' : '-');
+            print_ch((entry->flags & MACTAB_FLAG_AGED)     ? 'A' : '-');
+            print_ch((entry->flags & MACTAB_FLAG_CPU_COPY) ? 'C' : '-');
             print_cr_lf();
+            total++;
+        }
+    } while (cnt == MACTAB_CLI_CHUNK);
+    print_str("Entries: ");
+    print_dec(total);
+    print_cr_lf();
+}
+
+#if TRANSIT_MACTAB_STAT
+static void cmd_print_mactab_stat(void)
+{
+    mactab_stat_t xdata stat;
+    uchar         i;
+
+    h2_mactab_stat_get(&stat);
+    print_str("Scans:        ");
+    print_dec(stat.scan_cnt);
+    print_cr_lf();
+    print_str("Dynamic:      ");
+    print_dec(stat.dynamic_cnt);
+    print_cr_lf();
+    print_str("Static:       ");
+    print_dec(stat.static_cnt);
+    print_cr_lf();
+    print_str("Multicast:    ");
+    print_dec(stat.mc_cnt);
+    print_cr_lf();
+    print_str("Free:         ");
+    print_dec((ushort) (MACTAB_ROWS * MACTAB_BUCKETS) -
+              stat.dynamic_cnt - stat.static_cnt - stat.mc_cnt);
+    print_cr_lf();
+    for (i = 0; i <= MACTAB_BUCKETS; i++) {
+        print_str("Rows with ");
+        print_dec(i);
+        print_str(":  ");
+        print_dec(stat.row_cnt[i]);
+        print_cr_lf();
+    }
+    print_str("Learn failed: ");
+    print_dec(stat.learn_fail_cnt);
+    print_cr_lf();
+    for (i = 0; i <= LUTON26_ICPU_PORT; i++) {
+        if (stat.port_cnt[i] == 0) {
+            continue;
+        }
+        if (i == LUTON26_ICPU_PORT) {
+            print_str("Port CPU:     ");
+        } else {
+            print_str("Port ");
+            print_dec_nright(port2ext(i), 2);
+            print_str(":      ");
         }
+        print_dec(stat.port_cnt[i]);
+        print_cr_lf();
     }
+}
+#endif
 
-#if FRONT_LED_PRESENT
-    delay(MSEC_100);
-    for (port_no_ext = 1; port_no_ext < MAX_PORT; port_no_ext++) {
-        port_no = port2int(port_no_ext);
+#if TRANSIT_LEARN_LIMIT
+static void cmd_print_learn_limit(void)
+{
+    uchar port_ext;
+    uchar port_no;
+    uchar limit;
+
+    println_str("Port  Entries  Limit  Storms  Hold");
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        port_no = port2int(port_ext);
+        print_dec_nright(port_ext, 4);
+        print_dec_nright(h2_mactab_learn_cnt_get(port_no), 9);
+        limit = h2_mactab_learn_limit_get(port_no);
+        if (limit >= LEARN_LIMIT_NONE) {
+            print_str("   None");
+        } else {
+            print_dec_nright(1UL << limit, 7);
+        }
+        print_dec_nright(h2_mactab_learn_storm_get(port_no), 8);
+        print_dec_nright(h2_mactab_learn_hold_get(port_no), 6);
+        print_cr_lf();
+    }
+    print_str("Over limit:       ");
+    println_str(h2_mactab_learn_drop_get() ? "Drop" : "Forward");
+    print_str("Limit drop secs:  ");
+    print_dec(h2_mactab_learn_drop_sec_get());
+    print_cr_lf();
+    print_str("Learn discards:   ");
+    print_dec(h2_mactab_learn_disc_get());
+    print_cr_lf();
+}
+#endif
+
+#if TRANSIT_AGE_ADAPT
+static void cmd_print_age_adapt(void)
+{
+    mactab_age_stat_t xdata age;
+
+    h2_mactab_age_stat_get(&age);
+    print_str("Age time:         ");
+    print_dec(age.age_time);
+    print_str(" sec (");
+    print_dec(AGE_TIME_MIN);
+    print_str("-");
+    print_dec(AGE_TIME_MAX);
+    println_str(")");
+    print_str("Learned entries:  ");
+    print_dec(age.entries);
+    print_str(" (low ");
+    print_dec(AGE_ADAPT_LOW);
+    print_str(", high ");
+    print_dec(AGE_ADAPT_HIGH);
+    println_str(")");
+    print_str("Lowered/raised:   ");
+    print_dec(age.lower_cnt);
+    print_ch('/');
+    print_dec(age.raise_cnt);
+    print_cr_lf();
+    if (age.lower_cnt || age.raise_cnt) {
+        print_str("Last change:      ");
+        print_dec(age.since);
+        print_str(" sec ago at ");
+        print_dec(age.change_entries);
+        println_str(" entries");
+    }
+    print_str("Hold:             ");
+    print_dec(age.hold);
+    println_str(" sec");
+}
+#endif
+
+#if TRANSIT_PORT_RATE
+static void cmd_print_port_rate(void)
+{
+    port_rate_t xdata avg;
+    port_rate_t xdata peak;
+    uchar             port_ext;
+    uchar             port_no;
+    uchar             i;
+
+    println_str("    ----------- Average -----------  ------------ Peak -------------");
+    println_str("Port  RX fps RX kbps  TX fps TX kbps   RX fps RX kbps  TX fps TX kbps  Load");
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        port_no = port2int(port_ext);
+        h2_stats_rate_get(port_no, &avg, &peak);
+        print_dec_nright(port_ext, 4);
+        for (i = 0; i < STATS_RATE_CNT; i++) {
+            /* Bit rates in kbps to keep the columns narrow */
+            print_dec_nright((i & 1) ? avg.val[i] / 1000 : avg.val[i], 8);
+        }
+        print_spaces(1);
+        for (i = 0; i < STATS_RATE_CNT; i++) {
+            print_dec_nright((i & 1) ? peak.val[i] / 1000 : peak.val[i], 8);
+        }
+        print_dec_nright(h2_stats_load_get(port_no), 5);
+        println_str("%");
+    }
+}
+#endif
 
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            led_state_set(port_no_ext, VTSS_LED_EVENT_CABLE, VTSS_LED_MODE_NORMAL);
+#if TRANSIT_DROP_STAT
+static void cmd_print_drop_stat(void)
+{
+    port_drop_t  xdata avg;
+    port_drop_t  xdata peak;
+    port_buf_t   xdata buf;
+    buf_usage_t  xdata usage;
+    drop_event_t xdata ev;
+    uchar              port_ext;
+    uchar              port_no;
+    uchar              i;
+
+    /* Port reservations are in units of 48 bytes, the switch buffer in 192 bytes */
+    println_str("    ------------- Average -------------  -------------- Peak ---------------  -- Buf kB --");
+    println_str("Port   Tail  Local   Aged  RxPse  TxPse     Tail  Local   Aged  RxPse  TxPse      In    Eg");
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        port_no = port2int(port_ext);
+        h2_stats_drop_get(port_no, &avg, &peak);
+        h2_stats_buf_get(port_no, &buf);
+        print_dec_nright(port_ext, 4);
+        for (i = 0; i < STATS_DROP_CAUSE_CNT; i++) {
+            print_dec_nright(avg.rate[i], 7);
         }
+        print_spaces(2);
+        for (i = 0; i < STATS_DROP_CAUSE_CNT; i++) {
+            print_dec_nright(peak.rate[i], 7);
+        }
+        print_spaces(2);
+        print_dec_nright((ulong) buf.ingress * 48 / 1024, 6);
+        print_dec_nright((ulong) buf.egress * 48 / 1024, 6);
+        print_cr_lf();
+    }
+
+    h2_stats_buf_usage_get(&usage);
+    print_str("Buffer in use:    ");
+    print_dec((ulong) usage.used * 192 / 1024);
+    print_str(" of ");
+    print_dec((ulong) usage.total * 192 / 1024);
+    print_str(" kB, peak ");
+    print_dec((ulong) usage.peak * 192 / 1024);
+    print_str(" kB ");
+    print_dec((usage.tick - usage.peak_tick) / 10);
+    println_str(" sec ago");
+
+    println_str("Port  Start  End sec ago       Drops  Buf kB   In kB   Eg kB");
+    for (i = 0; h2_stats_drop_event_get(i, &ev); i++) {
+        print_dec_nright(port2ext(ev.port_no), 4);
+        print_dec_nright((usage.tick - ev.tick_first) / 10, 7);
+        print_dec_nright((usage.tick - ev.tick_last) / 10, 5);
+        print_dec_nright(ev.drops, 20);
+        print_dec_nright((ulong) ev.buf_used * 192 / 1024, 8);
+        print_dec_nright((ulong) ev.port_buf.ingress * 48 / 1024, 8);
+        print_dec_nright((ulong) ev.port_buf.egress * 48 / 1024, 8);
+        print_cr_lf();
     }
+}
 #endif
+
+#if TRANSIT_IGMP_SNOOP
+static void cmd_print_igmp(void)
+{
+    igmp_group_info_t xdata info;
+    uchar             xdata *ip;
+    uchar             idx;
+    uchar             i;
+    uchar             width;
+    code char *cnt_txt[IGMP_CNT_CNT] = {
+        "Queries:      ", "Reports:      ", "V3 reports:   ",
+        "Leaves:       ", "Invalid:      ", "Table full:   "
+    };
+
+    println_str("Group            VID   Ports");
+    for (idx = 0; idx < IGMP_GROUP_MAX; idx++) {
+        if (!h2_igmp_group_get(idx, &info)) {
+            continue;
+        }
+        ip = (uchar xdata *) &info.group;
+        print_ip_addr(ip);
+        for (i = 0, width = 3; i < 4; i++) {
+            width += 1 + (ip[i] >= 10) + (ip[i] >= 100);
+        }
+        print_spaces(17 - width);
+        print_dec_nright(info.vid, 4);
+        print_spaces(2);
+        cmd_print_port_list(info.members);
+    }
+    print_str("Router ports: ");
+    cmd_print_port_list(h2_igmp_router_ports_get());
+    for (i = 0; i < IGMP_CNT_CNT; i++) {
+        print_str(cnt_txt[i]);
+        print_dec(h2_igmp_cnt_get(i));
+        print_cr_lf();
+    }
+}
+
+static void cmd_print_port_list(port_bit_mask_t mask)
+{
+    uchar port_ext;
+
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        if (TEST_PORT_BIT_MASK(port2int(port_ext), &mask)) {
+            print_spaces(1);
+            print_dec(port_ext);
+        }
+    }
+    print_cr_lf();
 }
 #endif
+#endif
 
 #if TRANSIT_LLDP
 #if UNMANAGED_LLDP_DEBUG_IF
@@ -1287,6 +1790,13 @@ static uchar handle_sys_config (void)
         /* Dump all configurations */
         flash_read_mac_addr(&mac_addr);
         print_mac_addr(mac_addr);
+#if TRANSIT_BUF_PROFILE
+        print_cr_lf();
+        print_str("Buffer profile: ");
+        print_dec(h2_buf_profile_get());
+        print_spaces(1);
+        print_str(h2_buf_profile_name(h2_buf_profile_get()));
+#endif
     } else {
         if(cmp_cmd_txt(CMD_TXT_NO_MAC, str_parms[0].str))  {
             /* Update MAC addresses in RAM */
@@ -1300,6 +1810,15 @@ static uchar handle_sys_config (void)
             flash_write_mac_addr(&mac_addr);
 #if TRANSIT_LLDP
             lldp_something_changed_local();
+#endif
+#if TRANSIT_BUF_PROFILE
+        } else if(cmp_cmd_txt(CMD_TXT_NO_BUF, str_parms[0].str)) {
+            /* Select the buffer profile, applied at once and kept in RAM */
+            if(str_parms[1].len != 1 ||
+                    str_parms[1].str[0] < '0' || str_parms[1].str[0] >= '0' + BUF_PROFILE_CNT)
+                return FORMAT_ERROR;
+            flash_write_buf_profile(str_parms[1].str[0] - '0');
+            h2_buf_profile_set(str_parms[1].str[0] - '0');
 #endif
         } else if(cmp_cmd_txt(CMD_TXT_NO_SAVE, str_parms[0].str)) {
             /* Program configurations at RAM to flash */
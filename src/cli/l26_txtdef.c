@@ -22,6 +22,10 @@ const char txt_CMD_TXT_NO_MAC [] = {"MAC"};
 
 const char txt_CMD_TXT_NO_SAVE [] = {"SAVE"};
 
+#if TRANSIT_BUF_PROFILE
+const char txt_CMD_TXT_NO_BUF [] = {"BUF"};
+
+#endif
 #endif
 const char txt_CMD_TXT_NO_END [] = {"END"};
 
@@ -35,6 +39,9 @@ const struct {
     txt_CMD_TXT_NO_CONFIG,                     6,
     txt_CMD_TXT_NO_MAC,                        3,
     txt_CMD_TXT_NO_SAVE,                       4,
+#if TRANSIT_BUF_PROFILE
+    txt_CMD_TXT_NO_BUF,                        3,
+#endif
 #endif
     txt_CMD_TXT_NO_END,                        3,
 };
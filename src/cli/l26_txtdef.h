@@ -20,6 +20,9 @@
 extern const char txt_CMD_TXT_NO_CONFIG [];
 extern const char txt_CMD_TXT_NO_MAC [];
 extern const char txt_CMD_TXT_NO_SAVE [];
+#if TRANSIT_BUF_PROFILE
+extern const char txt_CMD_TXT_NO_BUF [];
+#endif
 #endif
 extern const char txt_CMD_TXT_NO_END [];
 
@@ -29,6 +32,9 @@ typedef enum {
     CMD_TXT_NO_CONFIG,
     CMD_TXT_NO_MAC,
     CMD_TXT_NO_SAVE,
+#if TRANSIT_BUF_PROFILE
+    CMD_TXT_NO_BUF,
+#endif
 #endif
     CMD_TXT_NO_END,
     END_CMD_TXT,
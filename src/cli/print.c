@@ -206,6 +206,7 @@ void print_dec_8_right_2 (uchar value)
 #endif
 
 #if UNMANAGED_PORT_STATISTICS_IF
+#if 0 //uncall functions
 /* ************************************************************************ */
 void print_dec_right (ulong value)
 /* ------------------------------------------------------------------------ --
@@ -221,8 +222,52 @@ void print_dec_right (ulong value)
 }
 #endif
 
+/* ************************************************************************ */
+void print_dec_64_nright (ulong hi, ulong lo, uchar fieldwidth)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Print a 64-bit value, given as two 32-bit halves, as a
+ *               decimal number right adjusted in a <fieldwidth>-char field.
+ * Remarks     : Longer numbers take the digits they need.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ushort limb [4];
+    uchar  buf [20];
+    uchar  no_of_digits;
+    uchar  i;
+    ulong  rem;
+
+    limb[0] = (ushort) (hi >> 16);
+    limb[1] = (ushort) hi;
+    limb[2] = (ushort) (lo >> 16);
+    limb[3] = (ushort) lo;
+
+    /* Divide by 10 a 16-bit limb at a time */
+    no_of_digits = 0;
+    do {
+        rem = 0;
+        for (i = 0; i < 4; i++) {
+            rem = (rem << 16) | limb[i];
+            limb[i] = (ushort) (rem / 10);
+            rem = rem % 10;
+        }
+        buf[no_of_digits++] = (uchar) rem + '0';
+    } while (limb[0] | limb[1] | limb[2] | limb[3]);
+
+    while (fieldwidth > no_of_digits) {
+        uart_put_byte(' ');
+        fieldwidth--;
+    }
+    while (no_of_digits-- > 0) {
+        uart_put_byte(buf[no_of_digits]);
+    }
+}
+#endif
+
 
-#if UNMANAGED_EEE_DEBUG_IF
+#if UNMANAGED_EEE_DEBUG_IF || LOOPBACK_TEST || !defined(UNMANAGED_REDUCED_DEBUG_IF)
 /* ************************************************************************ */
 void print_dec_nright (ulong value, uchar fieldwidth)
 /* ------------------------------------------------------------------------ --
@@ -335,7 +380,7 @@ void print_spaces (uchar count)
 }
 #endif
 
-#if UNMANAGED_LLDP_DEBUG_IF
+#if UNMANAGED_LLDP_DEBUG_IF || (TRANSIT_IGMP_SNOOP && !defined(UNMANAGED_REDUCED_DEBUG_IF))
 /* ************************************************************************ */
 void print_ip_addr (const uchar xdata *ip_addr)
 /* ------------------------------------------------------------------------ --
@@ -413,7 +458,7 @@ void print_line (uchar width)
 }
 #endif
 
-#if UNMANAGED_EEE_DEBUG_IF || UNMANAGED_PORT_STATISTICS_IF
+#if UNMANAGED_EEE_DEBUG_IF || UNMANAGED_PORT_STATISTICS_IF || LOOPBACK_TEST || !defined(UNMANAGED_REDUCED_DEBUG_IF)
 /* ************************************************************************ */
 static void print_dec_32 (ulong value, uchar adjust, uchar fieldwidth)
 /* ------------------------------------------------------------------------ --
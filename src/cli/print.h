@@ -17,8 +17,11 @@ void print_hex_prefix (void);
 void print_cr_lf (void);
 void print_ch (uchar ch);
 void print_spaces (uchar count);
+#if 0 //uncall functions
 void print_dec_right (ulong value);
+#endif
 void print_dec_nright (ulong value, uchar fieldwidth);
+void print_dec_64_nright (ulong hi, ulong lo, uchar fieldwidth);
 void print_dec_16_right (ushort value, uchar width);
 void print_ip_addr (const uchar xdata *ip_addr);
 void print_line (uchar width);
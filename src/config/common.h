@@ -23,14 +23,22 @@
 
 typedef unsigned char   uchar;
 typedef unsigned int    uint;
+#ifdef TXRXBENCH_HOST
+typedef unsigned int    ulong;  /* 32 bits also in the PC build of tools/txrxbench */
+#else
 typedef unsigned long   ulong;
+#endif
 typedef unsigned short  ushort;
 typedef bit             bool;
 typedef unsigned char   BOOL; /**< Boolean implemented as 8-bit unsigned */
 
 typedef unsigned char   u8;
 typedef unsigned short  u16;
+#ifdef TXRXBENCH_HOST
+typedef unsigned int    u32;
+#else
 typedef unsigned long   u32;
+#endif
 
 /****************************************************************************
  * Port Types
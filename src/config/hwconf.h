@@ -169,9 +169,11 @@ sbit GPR7     = 0x87;
 /*
  * Define whether PHY loopback test should be supported
  * Set LOOPBACK_TEST to 1, if loopback test should be supported, otherwise set
- * it to 0
+ * it to 0. The host build of tools/txrxbench sets it on the command line.
  */
+#ifndef LOOPBACK_TEST
 #define LOOPBACK_TEST   0
+#endif
 
 /*****************************************************************************
  *
@@ -251,6 +253,83 @@ sbit GPR7     = 0x87;
 */
 #define JUMBO_SIZE 9600
 
+/*****************************************************************************
+ *
+ *
+ * CPU frame extraction
+ *
+ *
+ *
+ ****************************************************************************/
+
+/*
+** Define how frames to the CPU are extracted.
+** Set USE_FDMA_XTR to 1 to let the FDMA move frames into a ring of buffers in
+** SBA RAM, from where they are loaded into rx_packet in one go. The board must
+** have RAM (DDR) set up at FDMA_RAM_BASE before the switch is initialized.
+** Set it to 0 to read frames word by word from the extraction registers.
+*/
+#define USE_FDMA_XTR  0
+
+/*
+** Set USE_FDMA_INJ to 1 to let the FDMA send CPU frames from SBA RAM. The
+** frame is copied there in one go and the sender does not wait for it to
+** leave. Set it to 0 to write frames word by word to the injection registers.
+*/
+#define USE_FDMA_INJ  0
+
+/*
+** Set USE_XTR_IRQ to 1 to let the XTR_RDY interrupts tell which extraction
+** groups have frames. The interrupt wakes the 8051 from idle and only those
+** groups are read, so an idle main loop does not poll empty groups.
+** Set it to 0 to check all groups on each main loop pass.
+*/
+#define USE_XTR_IRQ   0
+
+/*
+** SBA address of the RAM used for FDMA descriptors and frame buffers.
+*/
+#define FDMA_RAM_BASE 0x00100000UL
+
+/*
+** Frames extracted to the CPU are held in a ring of RX_RING_CNT buffers until
+** they are processed. Each main loop pass moves at most RX_BUDGET_GRP0/1
+** frames from extraction group 0/1 into the ring, and processes at most
+** RX_PROCESS_BUDGET frames from it, so a burst is carried over to the next
+** passes. The ring must be deeper than the extraction budget of a pass.
+** While the ring is full, frames are left in the extraction groups and the
+** pass is counted as a stall, see the CLI command "P". Each buffer takes
+** RECV_BUFSIZE+2 bytes of xdata.
+*/
+#define RX_RING_CNT         4
+#define RX_BUDGET_GRP0      2   /* Group 0 carries LLDP */
+#define RX_BUDGET_GRP1      1
+#define RX_PROCESS_BUDGET   2
+
+/*
+** Extraction group 0/1 prunes frames to RX_PRUNE_GRP0/1 bytes, so a frame
+** costs a bounded number of register reads whatever lands on the CPU. 0
+** disables pruning, otherwise the range is 16-1016 bytes. Group 0 carries
+** LLDP and IGMP and is not pruned, as an LLDPDU may take up to 1500 bytes,
+** more than the longest pruning. Its cost per frame is thus only bounded by
+** the max. frame length of the ports, JUMBO_SIZE with JUMBO: a frame longer
+** than RECV_BUFSIZE is read to the end and dropped. Group 1 carries no
+** frames the CPU parses and only needs the 16 bytes used to classify them.
+** Pruned and too long frames are counted and dropped, with the length of
+** the longest too long one, see the CLI command "P". With
+** RX_TRUNCATE_CPU_QU the CPU queues not carrying LLDP or IGMP also truncate
+** frames to 92 bytes while they are queued, saving packet memory.
+** The loopback test compares whole frames and needs all of it disabled.
+*/
+#if LOOPBACK_TEST
+#define RX_PRUNE_GRP0       0
+#define RX_PRUNE_GRP1       0
+#define RX_TRUNCATE_CPU_QU  0
+#else
+#define RX_PRUNE_GRP0       0       /* LLDPDUs of up to 1500 bytes, see RECV_BUFSIZE */
+#define RX_PRUNE_GRP1       16
+#define RX_TRUNCATE_CPU_QU  1
+#endif
 
 
 /****************************************************************************
@@ -15,6 +15,9 @@
 #include "timer.h"
 #include "print.h"
 #include "h2txrx.h" /* using uchar rx_packet[] */
+#if TRANSIT_BUF_PROFILE
+#include "h2bufcfg.h"
+#endif
 #include "timer.h"
 
 
@@ -108,6 +111,12 @@ struct config_contents {
     uchar       rt_idx;         // Runtime code index
     uchar       signature;      // Configuration signature
     mac_addr_t  sys_mac;        // System MAC address
+#if TRANSIT_CPU_POLICING
+    uchar       cpu_pol_rate[CPU_POL_CNT]; // CPU policer rates, see h2_cpu_pol_set()
+#endif
+#if TRANSIT_BUF_PROFILE
+    uchar       buf_profile;    // Buffer profile, see h2_buf_profile_set()
+#endif
 };
 
 struct flash_info {
@@ -796,9 +805,21 @@ void flash_load_config (void)
         /* Set all configuration to all 0 and use the default MAC address
            when the signature is not valid */
         mac_copy(&config_shadow.sys_mac, spiflash_mac_addr);
+#if TRANSIT_CPU_POLICING
+        memset(config_shadow.cpu_pol_rate, CPU_POL_DEFAULT, CPU_POL_CNT);
+#endif
+#if TRANSIT_BUF_PROFILE
+        config_shadow.buf_profile = BUF_PROFILE_UNSET;
+#endif
     }
 #else
     mac_copy(&config_shadow.sys_mac, spiflash_mac_addr);
+#if TRANSIT_CPU_POLICING
+    memset(config_shadow.cpu_pol_rate, CPU_POL_DEFAULT, CPU_POL_CNT);
+#endif
+#if TRANSIT_BUF_PROFILE
+    config_shadow.buf_profile = BUF_PROFILE_UNSET;
+#endif
 #endif
 }
 
@@ -821,3 +842,35 @@ uchar flash_write_mac_addr (uchar xdata *mac_addr)
 }
 #endif
 
+#if TRANSIT_CPU_POLICING
+/* Encoded CPU policer rate, CPU_POL_DEFAULT if never configured */
+uchar flash_read_cpu_pol (uchar pol)
+{
+    return config_shadow.cpu_pol_rate[pol];
+}
+
+#if LUTON_UNMANAGED_CONF_IF
+/* Only update RAM copy; call flash_program_config to write into flash */
+void flash_write_cpu_pol (uchar pol, uchar rate)
+{
+    config_shadow.cpu_pol_rate[pol] = rate;
+}
+#endif
+#endif /* TRANSIT_CPU_POLICING */
+
+#if TRANSIT_BUF_PROFILE
+/* Buffer profile, BUF_PROFILE_UNSET if never configured */
+uchar flash_read_buf_profile (void)
+{
+    return config_shadow.buf_profile;
+}
+
+#if LUTON_UNMANAGED_CONF_IF
+/* Only update RAM copy; call flash_program_config to write into flash */
+void flash_write_buf_profile (uchar profile)
+{
+    config_shadow.buf_profile = profile;
+}
+#endif
+#endif /* TRANSIT_BUF_PROFILE */
+
@@ -65,6 +65,14 @@ void flash_load_config (void);
 /* Functions for updating/reading config at RAM shadow */
 void flash_read_mac_addr (uchar xdata *mac_addr);
 uchar flash_write_mac_addr (uchar xdata *mac_addr);
+#if TRANSIT_CPU_POLICING
+uchar flash_read_cpu_pol (uchar pol);
+void flash_write_cpu_pol (uchar pol, uchar rate);
+#endif
+#if TRANSIT_BUF_PROFILE
+uchar flash_read_buf_profile (void);
+void flash_write_buf_profile (uchar profile);
+#endif
 
 /*
  * Flash initialization
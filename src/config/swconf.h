@@ -86,6 +86,150 @@
 #define TRANSIT_BPDU_PASS_THROUGH           0
 
 
+/****************************************************************************
+ * CPU policing - limit the rate of flooded and learn frames to the CPU so a
+ * storm cannot starve LLDP and loop detection. The rates are in frames per
+ * second, rounded down to a power of two, 0 disables a policer. They can be
+ * changed with the CLI command "Q" and saved with "CONFIG SAVE".
+ ****************************************************************************/
+#define TRANSIT_CPU_POLICING                1
+#define CPU_POL_UC_FPS                      256
+#define CPU_POL_BC_FPS                      256
+#define CPU_POL_MC_FPS                      256
+#define CPU_POL_LEARN_FPS                   1024
+
+
+/****************************************************************************
+ * Buffer profiles - the watermarks of the shared buffer are computed from a
+ * profile and the link speed of each port, see h2bufcfg.h. 0 is balanced,
+ * the fixed scheme of earlier releases, 1 absorbs bursts, 2 keeps the
+ * queues short for low latency and 3 reserves a jumbo frame per port. With
+ * TRANSIT_BUF_PROFILE the profile is stored in the flash configuration,
+ * changed with "CONFIG BUF n" and saved with "CONFIG SAVE". The host tool
+ * tools/bufcalc.c prints the watermarks of a profile.
+ ****************************************************************************/
+#define TRANSIT_BUF_PROFILE                 1
+#define BUF_PROFILE_DEFAULT                 0
+
+
+/****************************************************************************
+ * MAC table statistics - scan the MAC table on demand, a few rows every
+ * 10 msec, counting entries per port, static and dynamic entries and how
+ * many of the 4 buckets of each hash row are used. Full rows make new
+ * addresses fail to learn and be flooded. The CLI command "M" shows the last
+ * scan and starts a new one, the table is not read otherwise.
+ ****************************************************************************/
+#define TRANSIT_MACTAB_STAT                 1
+#define MACTAB_SCAN_ROWS                    16  /* A sweep takes 1.3 sec */
+
+
+/****************************************************************************
+ * MAC learn limits - at most 2**LEARN_LIMIT_DEFAULT unlocked addresses are
+ * learned on a port, so a single port cannot take over the MAC table. Frames
+ * from new stations beyond the limit are forwarded without being learned, or
+ * dropped if LEARN_LIMIT_DROP is 1. A port learning LEARN_STORM_RATE or more
+ * addresses a second for LEARN_STORM_SEC seconds in a row is flushed and held
+ * at 2**LEARN_STORM_LIMIT entries for LEARN_STORM_HOLD_SEC seconds. Ports are
+ * not checked for LEARN_STORM_GRACE_SEC seconds after link up, when a
+ * switch behind them learns all its stations. Off by default, as a port
+ * with more stations than the limit floods the frames to the rest.
+ * Shown and changed with CLI command "N".
+ ****************************************************************************/
+#define TRANSIT_LEARN_LIMIT                 0
+#define LEARN_LIMIT_DEFAULT                 10  /* 1024 entries */
+#define LEARN_LIMIT_DROP                    0
+#define LEARN_STORM_RATE                    256 /* 0 disables storm detection */
+#define LEARN_STORM_SEC                     3   /* Below 2**LEARN_LIMIT_DEFAULT / LEARN_STORM_RATE */
+#define LEARN_STORM_GRACE_SEC               10
+#define LEARN_STORM_LIMIT                   4   /* 16 entries */
+#define LEARN_STORM_HOLD_SEC                60
+
+
+/****************************************************************************
+ * Adaptive MAC ageing - every AGE_ADAPT_SEC seconds the number of learned
+ * entries is compared with two water marks. Above AGE_ADAPT_HIGH the age time
+ * is halved, down to AGE_TIME_MIN, so stale entries make room for new
+ * stations sooner. Below AGE_ADAPT_LOW it is doubled, up to AGE_TIME_MAX, to
+ * avoid flooding after quiet periods. After a change the age time is kept for
+ * at least the new age time, so the table can settle. Shown with CLI "K".
+ ****************************************************************************/
+#define TRANSIT_AGE_ADAPT                   1
+#define AGE_TIME_MIN                        75      /* Seconds */
+#define AGE_TIME_MAX                        1200    /* Seconds */
+#define AGE_ADAPT_SEC                       10
+#define AGE_ADAPT_HIGH                      6144    /* 75% of 8192 entries */
+#define AGE_ADAPT_LOW                       2048    /* 25% of 8192 entries */
+
+
+/****************************************************************************
+ * IGMP snooping - IGMPv2/v3 frames are redirected to the CPU, which learns
+ * the ports with listeners of each group and the ports with a multicast
+ * router (query sender) and forwards the frames itself. IPv4 multicast to a
+ * known group then only reaches its listeners and the router ports, and
+ * multicast to unknown groups only the router ports, or all ports with
+ * IGMP_UNREG_FLOOD or as long as no router port is known. At most
+ * IGMP_GROUP_MAX groups, each costing 32 bytes of xdata. While a report
+ * finds the table full, unregistered multicast is flooded to all ports
+ * for IGMP_MEMBER_TIMEOUT, so listeners of the groups left out get it.
+ * Shown with CLI command "U".
+ ****************************************************************************/
+#define TRANSIT_IGMP_SNOOP                  1
+#define IGMP_GROUP_MAX                      16      /* At most 32 */
+#define IGMP_MEMBER_TIMEOUT                 260     /* Seconds, 2 * 125 + 10 */
+#define IGMP_ROUTER_TIMEOUT                 255     /* Seconds, 2 * 125 + 5 */
+#define IGMP_LEAVE_TIMEOUT                  2       /* Seconds, 0 for fast leave */
+#define IGMP_UNREG_FLOOD                    0
+
+#if TRANSIT_IGMP_SNOOP && !TRANSIT_LLDP
+/* The receive path is only built for LLDP */
+#error "TRANSIT_IGMP_SNOOP depends on TRANSIT_LLDP, please set in swconf.h"
+#endif
+
+
+/****************************************************************************
+ * 64-bit port counters - the octet, frame, multicast and broadcast counters
+ * of the switch are 32 bits wide, and an octet counter of a 1 Gbps port
+ * wraps in 34 sec. They are read in the background, STATS_POLL_PORTS ports
+ * per 100 msec, and accumulated to 64-bit software counters. With one port
+ * per 100 msec all 26 ports are read every 2.6 sec.
+ ****************************************************************************/
+#define TRANSIT_STATS_64                    1
+#define STATS_POLL_PORTS                    1
+
+
+/****************************************************************************
+ * Port rates - each time a port's counters are read in the background, its
+ * RX and TX frames and bits per second since the last read are sampled. The
+ * average weighs each sample 1/2**STATS_RATE_EWMA_SHIFT, and the highest
+ * sample is held as the peak. Shown with CLI command "J", and available to
+ * other modules as the load of a port.
+ ****************************************************************************/
+#define TRANSIT_PORT_RATE                   1
+#define STATS_RATE_EWMA_SHIFT               2   /* Averages about 4 samples */
+
+#if TRANSIT_PORT_RATE && !TRANSIT_STATS_64
+/* The samples are taken by h2_stats_poll() */
+#error "TRANSIT_PORT_RATE depends on TRANSIT_STATS_64, please set in swconf.h"
+#endif
+
+
+/****************************************************************************
+ * Drop statistics - with each port rate sample the tail drops, local drops,
+ * aged frames and pause frames of the port are sampled as per second rates
+ * as well, together with the highest use of the port's ingress and egress
+ * buffer reservations. Samples with tail drops or aged frames are recorded
+ * as congestion events, the last DROP_EVENT_MAX of them, with the switch
+ * buffer use at the time. Shown with CLI command "Y".
+ ****************************************************************************/
+#define TRANSIT_DROP_STAT                   1
+#define DROP_EVENT_MAX                      8
+
+#if TRANSIT_DROP_STAT && !TRANSIT_PORT_RATE
+/* The drops are sampled with the port rates */
+#error "TRANSIT_DROP_STAT depends on TRANSIT_PORT_RATE, please set in swconf.h"
+#endif
+
+
 /****************************************************************************
  *
  *
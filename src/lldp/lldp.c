@@ -251,6 +251,7 @@ void lldp_construct_shutdown_lldpdu (lldp_port_t port_no)
 void lldp_tx_frame (lldp_port_t port_no)
 {
     lldp_u8_t xdata * buf;
+    lldp_u8_t xdata hdr[14];
     vtss_common_macaddr_t mac_addr;
     lldp_sm_t xdata * sm;
 
@@ -267,21 +268,22 @@ void lldp_tx_frame (lldp_port_t port_no)
 
     buf = lldp_os_get_frame_storage();
 
-    /* fill in SA, DA + eth Type */
-    buf[0] = 0x01;
-    buf[1] = 0x80;
-    buf[2] = 0xC2;
-    buf[3] = 0x00;
-    buf[4] = 0x00;
-    buf[5] = 0x0E;
+    /* fill in SA, DA + eth Type. The room reserved for them in buf is not
+       used, the header is sent as a fragment of its own. */
+    hdr[0] = 0x01;
+    hdr[1] = 0x80;
+    hdr[2] = 0xC2;
+    hdr[3] = 0x00;
+    hdr[4] = 0x00;
+    hdr[5] = 0x0E;
 
-    VTSS_COMMON_MACADDR_ASSIGN(&buf[6], mac_addr.macaddr);
+    VTSS_COMMON_MACADDR_ASSIGN(&hdr[6], mac_addr.macaddr);
 
-    buf[12] = 0x88;
-    buf[13] = 0xCC;
+    hdr[12] = 0x88;
+    hdr[13] = 0xCC;
 
     VTSS_COMMON_TRACE(VTSS_COMMON_TRLVL_DEBUG, ("Port %u Tx Frame", (unsigned)port_no));
-    lldp_os_tx_frame(port_no, buf, frame_len);
+    lldp_os_tx_frame(port_no, hdr, &buf[14], frame_len - 14);
 }
 
 
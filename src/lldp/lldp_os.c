@@ -21,6 +21,7 @@
 #include "lldp_tlv.h"
 
 #include "h2txrx.h"
+#include "h2txrxaux.h"
 #if TRANSIT_LLDP
 
 /*****************************************************************************
@@ -206,9 +207,16 @@ lldp_u8_t lldp_os_get_ip_enabled (void)
 #endif
 
 /* send a frame on external port number */
-void lldp_os_tx_frame (lldp_port_t port_no, lldp_u8_t xdata * frame, lldp_u16_t len)
+void lldp_os_tx_frame (lldp_port_t port_no, lldp_u8_t xdata * hdr, lldp_u8_t xdata * body, lldp_u16_t body_len)
 {
-    h2_send_frame(port2int(port_no), frame, len);
+    vtss_tx_frag_t frags[2];
+
+    /* DA, SA and EthType, then the LLDPDU, straight from where they are */
+    frags[0].buf = hdr;
+    frags[0].len = 14;
+    frags[1].buf = body;
+    frags[1].len = body_len;
+    (void) h2_tx_frame_sg(port2int(port_no), frags, 2, VTSS_VID_NULL);
 }
 
 lldp_u32_t lldp_os_get_sys_up_time (void)
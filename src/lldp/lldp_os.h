@@ -76,7 +76,7 @@ void lldp_os_set_tx_delay (lldp_timer_t val);
 lldp_u8_t xdata * lldp_os_get_frame_storage (void);
 lldp_admin_state_t lldp_os_get_admin_status (lldp_port_t port);
 void lldp_os_set_admin_status (lldp_port_t port, lldp_admin_state_t admin_state);
-void lldp_os_tx_frame (lldp_port_t port_no, lldp_u8_t xdata * frame, lldp_u16_t len);
+void lldp_os_tx_frame (lldp_port_t port_no, lldp_u8_t xdata * hdr, lldp_u8_t xdata * body, lldp_u16_t body_len);
 void lldp_os_get_if_descr (lldp_port_t port, lldp_u8_t xdata * dest);
 void lldp_os_get_system_name (lldp_u8_t xdata * dest);
 void lldp_os_get_system_descr (lldp_u8_t xdata * dest);
@@ -25,6 +25,11 @@
 #include "traps.h"
 #endif
 
+#if USE_HW_TWI
+#include "i2c_h.h"
+#include "phytsk.h"
+#endif
+
 /*****************************************************************************
  *
  *
@@ -146,6 +151,29 @@ void callback_delayed_eee_lpi(void)
 }
 #endif /* TRANSIT_EEE */
 
+#if USE_HW_TWI
+/**
+ * Hand a finished TWI transaction back to the module that submitted it.
+ *
+ * @note Called by i2c_h.c, from i2c_tsk() or a blocking I2C call.
+ */
+void callback_i2c_done (uchar client, uchar tag, BOOL ok)
+{
+    tag = tag;                  /* make compiler happy */
+    ok  = ok;
+
+    switch (client) {
+#if MAC_TO_MEDIA && TRANSIT_SFP_DETECT
+    case I2C_CLIENT_SFP:
+        phy_sfp_id_done(tag, ok);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+#endif /* USE_HW_TWI */
+
 
 
 /****************************************************************************/
@@ -11,6 +11,9 @@
 void  callback_delayed_eee_lpi             (void);
 void  callback_link_up                     (vtss_port_no_t port_no);
 void  callback_link_down                   (vtss_port_no_t port_no);
+#if USE_HW_TWI
+void  callback_i2c_done                    (uchar client, uchar tag, BOOL ok);
+#endif
 
 #endif /* __EVENT_H__ */
 
@@ -142,6 +142,37 @@ uchar i2c_get_byte (uchar do_ack)
     return ret;
 
 }
+
+/**
+ * Read cnt consecutive bytes from device addr starting at register reg in
+ * one transaction: the register is addressed once and the bytes are
+ * clocked out back-to-back, ACKing all but the last one.
+ *
+ * @return TRUE if the device acknowledged its address.
+ */
+uchar i2c_read_page (uchar addr, uchar reg, uchar *const value, uchar cnt)
+{
+    uchar c;
+
+    i2c_start();
+    if (i2c_send_byte(addr << 1) != 0) {
+        i2c_stop();
+        return FALSE;
+    }
+    (void) i2c_send_byte(reg);
+
+    /* Repeated start and switch to read */
+    i2c_start();
+    (void) i2c_send_byte((addr << 1) | 1);
+
+    for (c = 0; c < cnt; c++) {
+        value[c] = i2c_get_byte(c + 1 < cnt);
+    }
+
+    i2c_stop();
+
+    return TRUE;
+}
 #endif /* USE_SW_TWI */
 #endif /* TRANSIT_SFP_DETECT */
 
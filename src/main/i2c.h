@@ -9,6 +9,7 @@ void  i2c_start (void);
 void  i2c_stop (void);
 uchar i2c_send_byte (uchar d);
 uchar i2c_get_byte (uchar do_ack);
+uchar i2c_read_page (uchar addr, uchar reg, uchar *const value, uchar cnt);
 
 #endif
 
@@ -26,9 +26,40 @@
 #include "timer.h"
 #include "print.h"
 #include "i2c_h.h"
+#include "event.h"
 
 #define I2C_DEBUG 0
 
+/* Depth of the controller TX and RX FIFOs */
+#define I2C_FIFO_DEPTH      8
+
+/* Transactions that can wait for the controller */
+#define I2C_QUEUE_LEN       4
+
+/* Number of i2c_tsk() ticks (10 msec) a transaction may stay active */
+#define I2C_TRANS_TIMEOUT   10
+
+/* Bounce buffer of the blocking calls */
+#define I2C_SYNC_BUF_LEN    32
+
+/* Submitted transactions, served in order */
+static i2c_trans_t xdata *xdata i2c_queue [I2C_QUEUE_LEN];
+static uchar i2c_queue_head;
+static uchar i2c_queue_cnt;
+
+/*
+ * Transaction owned by i2c_interrupt() while it is I2C_TRANS_ACTIVE. The
+ * indexes below are only touched by the ISR until the state is final.
+ */
+static i2c_trans_t xdata *i2c_cur;
+static uchar i2c_wr_idx;    /* Next address byte to push */
+static uchar i2c_rd_req;    /* Read commands pushed */
+static uchar i2c_rd_idx;    /* Bytes received */
+static uchar i2c_ticks;
+
+static i2c_trans_t xdata i2c_sync_trans;
+static uchar xdata i2c_sync_buf [I2C_SYNC_BUF_LEN];
+
 // Since the tar register only must be changed when the controller is disabled
 // we have a special function for setting the tar register.
 void i2c_set_tar_register(const ushort i2c_addr)
@@ -67,52 +98,6 @@ void i2c_set_tar_register(const ushort i2c_addr)
     }
 }
 
-// Function for waiting until the TX buffer is empty . This is needed for making sure that
-// multiple I2C transactions aren't concatenated into one transaction at the I2C bus.
-//
-// If the buffer isn't emptied within 500 ms the function returns 0 else 1
-static int wait_for_tx_buffer_empty(void)
-{ //James
-
-   ulong value;
-
-   // Check if TX fifo is empty. If not wait until it is.
-   start_timer(MSEC_500);
-
-    do {
-        H2_READ(VTSS_TWI_TWI_TXFLR, value);
-        if (timeout()) {
-            // Fifo was not emptied within 500 ms.
-            println_str("TX buffer empty Timeout\n");
-            return 0;
-        }
-    } while (value != 0);
-
-    return 1;
-}
-
-// Function for transmitting the data - returns 0 upon timeout failure.
-static int tx_i2c_data(const ulong tx_data)
-{ //James
-    ulong value;
-
-    start_timer(MSEC_50);
-
-    // Check if TX fifo is full. If so, wait until there is room for one more byte
-    do {
-        H2_READ(VTSS_TWI_TWI_TXFLR, value);
-        if (timeout()) {
-            // Fifo was not emptied within 50 ms.
-            println_str("I2C Tx Timeout");
-            return 0;
-        }
-    } while (value > 6);
-
-
-    H2_WRITE(VTSS_TWI_TWI_DATA_CMD, tx_data);
-    return 1;
-}
-
 // ----------------------------------------------------------------------------
 // The functions needed for all I2C devices.
 
@@ -216,214 +201,307 @@ void i2c_init(void)
     // Enable I2C controller
     H2_WRITE(VTSS_TWI_TWI_CTRL, VTSS_F_TWI_TWI_CTRL_ENABLE);
 
-    //James : no int in unmanaged Enable interrupt for when the hardware rx fifo contains data
-    //James H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0x04);
-    //James H2_WRITE(VTSS_TWI_TWI_RX_TL, 0x00); // 0x00 means one byte of data in the fifo
+    // Transfers are driven from the TWI interrupt, routed to iCPU_IRQ0.
+    // Events are masked until a transaction is started.
+    H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0);
+    H2_WRITE_MASKED(VTSS_ICPU_CFG_INTR_TWI_INTR_CFG,
+                    VTSS_F_ICPU_CFG_INTR_TWI_INTR_CFG_TWI_INTR_SEL(0),
+                    VTSS_M_ICPU_CFG_INTR_TWI_INTR_CFG_TWI_INTR_SEL);
+    H2_WRITE_MASKED(VTSS_ICPU_CFG_INTR_INTR_ENA,
+                    VTSS_F_ICPU_CFG_INTR_INTR_ENA_TWI_INTR_ENA,
+                    VTSS_F_ICPU_CFG_INTR_INTR_ENA_TWI_INTR_ENA);
 }
 
-ulong i2c_tx(const uchar i2c_addr,
-            const uchar *tx_data,
-            ulong count)
-{ //James
-    ulong bytes_transmitted = 0;
-    int tx_byte;
-
-    // Setup Target address register
-    i2c_set_tar_register(i2c_addr);
-
-    //  Do the write
-#if I2C_DEBUG
-    print_str("tx_data = ");
-#endif
-    if (wait_for_tx_buffer_empty()) {
-        for (tx_byte = count; tx_byte > 0; tx_byte--) {
-#if I2C_DEBUG
-            print_str("0x");
-            print_hex_b(*tx_data);
-#endif
-            if (tx_i2c_data(*tx_data)  == 0) {
-                // tx buffer remained full - timeout
-                break;
-            }
+// ----------------------------------------------------------------------------
+// Asynchronous transaction engine.
+//
+// A transaction is an optional write of up to I2C_WR_LEN_MAX bytes followed by
+// an optional read, done as one bus transfer with a repeated start. The ISR
+// keeps the FIFOs fed, so the main loop only starts transactions and collects
+// the result.
+
+#pragma NOAREGS
+/* ************************************************************************ */
+void i2c_interrupt (void) small
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Move the active transaction forward: drain the RX FIFO,
+ *               refill the TX FIFO and select the next event to wait for.
+ * Remarks     : Called from ext_0_interrupt.
+ * Restrictions: ISR could only call H2_READ, H2_WRITE, H2_WRITE_MASKED, no
+ *               other function is shared with main
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ulong stat;
+    ulong value;
+    uchar room;
+    uchar mask;
+    i2c_trans_t xdata *t = i2c_cur;
 
-            tx_data++; // Point to next data
-            bytes_transmitted++; // Ok - one more byte transmitted.
-            H2_WRITE_MASKED(VTSS_DEVCPU_GCB_GPIO_GPIO_OUT_CLR, VTSS_BIT(9), VTSS_BIT(9));
+    H2_READ(VTSS_TWI_TWI_INTR_STAT, stat);
 
-        }
+    if (t == XNULL || t->state != I2C_TRANS_ACTIVE) {
+        H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0);
+        return;
     }
-#if I2C_DEBUG
-    print_cr_lf();
-    print_str("TX UNLOCK: ");
-    print_dec(i2c_addr);
-    print_cr_lf();
-#endif
-    return bytes_transmitted;
-}
-
-#define HW_BUF_LEN 8
 
-#if 0 /* for debug */
-#define P_STR(a)            print_str(a)
-#define P_HEX_W(a)          print_hex_w(a)
-#define P_CR_LF()           print_cr_lf()
-#else
-#define P_STR(a)
-#define P_HEX_W(a)
-#define P_CR_LF()
-#endif
+    if (stat & VTSS_F_TWI_TWI_INTR_STAT_TX_ABRT) {
+        /* Address NACK or lost arbitration, the FIFOs have been flushed */
+        H2_READ(VTSS_TWI_TWI_CLR_TX_ABRT, value);
+        H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0);
+        t->state = I2C_TRANS_FAILED;
+        return;
+    }
 
-ulong i2c_rx(const uchar i2c_addr,
-             uchar* rx_data,
-             ulong count)
-{   //James
-    ulong bytes_recieved = 0;
-    ulong       value;
-	ulong       rx_byte;
-	int         byte_left ,i = 0;
+    /* Drain what has been received */
+    H2_READ(VTSS_TWI_TWI_RXFLR, value);
+    while (value != 0 && i2c_rd_idx < i2c_rd_req) {
+        H2_READ(VTSS_TWI_TWI_DATA_CMD, stat);
+        t->rd_buf[i2c_rd_idx++] = (uchar) stat;
+        value--;
+    }
 
-#if I2C_DEBUG
-    print_str("RX LOCK: ");
-    print_dec(i2c_addr); print_cr_lf();
-#endif
-    // Initialize the read
-    // Setup Target address register
-    i2c_set_tar_register(i2c_addr);
-#if I2C_DEBUG
-    print_str("Rx data = ");
-#endif
-    byte_left = count;
-    while (byte_left > 0)
-    {
-        if (byte_left > HW_BUF_LEN)
-            rx_byte = HW_BUF_LEN;
-        else
-            rx_byte = byte_left;
-        for (; rx_byte > 0; rx_byte--) {
-            if (wait_for_tx_buffer_empty()) {
-                if (tx_i2c_data(VTSS_F_TWI_TWI_DATA_CMD_CMD) == 0) {
-                    println_str("I2C - Couldn't transmit read request");
-                    return 0;
-                }
-            }
-            else{
-                println_str("wait_for_tx_buffer_empty");
-            }
+    /* Refill: address bytes first, then one read command per byte, never
+       more reads in flight than the RX FIFO can hold */
+    H2_READ(VTSS_TWI_TWI_TXFLR, value);
+    room = I2C_FIFO_DEPTH - (uchar) value;
+    while (room != 0 && i2c_wr_idx < t->wr_len) {
+        H2_WRITE(VTSS_TWI_TWI_DATA_CMD, t->wr_buf[i2c_wr_idx++]);
+        room--;
+    }
+    while (room != 0 && i2c_wr_idx == t->wr_len && i2c_rd_req < t->rd_len &&
+           (uchar) (i2c_rd_req - i2c_rd_idx) < I2C_FIFO_DEPTH) {
+        H2_WRITE(VTSS_TWI_TWI_DATA_CMD, VTSS_F_TWI_TWI_DATA_CMD_CMD);
+        i2c_rd_req++;
+        room--;
+    }
 
+    /* All is pushed and received. The transfer is only done when the
+       controller has sent the STOP and is idle, not when the TX FIFO ran
+       empty; STOP_DET is cleared before the check so none is missed */
+    if (i2c_wr_idx == t->wr_len && i2c_rd_idx == t->rd_len) {
+        H2_READ(VTSS_TWI_TWI_CLR_STOP_DET, value);
+        H2_READ(VTSS_TWI_TWI_TXFLR, value);
+        H2_READ(VTSS_TWI_TWI_STAT, stat);
+        if (value == 0 && !(stat & VTSS_F_TWI_TWI_STAT_MST_ACTIVITY)) {
+            H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0);
+            t->state = I2C_TRANS_DONE;
+        } else {
+            H2_WRITE(VTSS_TWI_TWI_INTR_MASK,
+                     VTSS_F_TWI_TWI_INTR_MASK_M_STOP_DET | VTSS_F_TWI_TWI_INTR_MASK_M_TX_ABRT);
         }
+        return;
+    }
 
-        // Set timeout to 100 msec.
-        //delay(MSEC_100);
-        start_timer(MSEC_100);
-        if (byte_left > HW_BUF_LEN)
-        {
-            rx_byte = HW_BUF_LEN;
-            byte_left = byte_left  - HW_BUF_LEN;
-        }
-        else
-        {
-            rx_byte = byte_left;
-            byte_left = 0;
-        }
+    mask = VTSS_F_TWI_TWI_INTR_MASK_M_TX_ABRT;
+    if (i2c_wr_idx < t->wr_len ||
+        (i2c_rd_req < t->rd_len && (uchar) (i2c_rd_req - i2c_rd_idx) < I2C_FIFO_DEPTH)) {
+        mask |= VTSS_F_TWI_TWI_INTR_MASK_M_TX_EMPTY;
+    }
+    if (i2c_rd_idx < i2c_rd_req) {
+        /* Wake up when all reads in flight have been answered */
+        H2_WRITE(VTSS_TWI_TWI_RX_TL, VTSS_F_TWI_TWI_RX_TL_RX_TL(i2c_rd_req - i2c_rd_idx - 1));
+        mask |= VTSS_F_TWI_TWI_INTR_MASK_M_RX_FULL;
+    }
+    H2_WRITE(VTSS_TWI_TWI_INTR_MASK, mask);
+}
+#pragma AREGS
 
-        for (; rx_byte > 0; rx_byte--) {
+/* Start the oldest queued transaction if the controller is free */
+static void i2c_start_next (void)
+{
+    i2c_trans_t xdata *t;
 
-            do {
-                H2_READ(VTSS_TWI_TWI_RXFLR, value);
-                //print_str("VTSS_TWI_TWI_RXFLR : ");
-                //print_dec(value);
-                //print_cr_lf();
-                if (timeout()) {
-                    // Fifo was not emptied within 100 ms.
-                    print_str("Read TimeOut(Addr) "); print_dec(i2c_addr);
-                    print_cr_lf();
+    if (i2c_cur != XNULL || i2c_queue_cnt == 0) {
+        return;
+    }
 
-                    /* Recover I2C when errors happen, for example,
-                       plug out SFP module when reading I2C data
-                    */
-                    H2_READ(VTSS_TWI_TWI_RAW_INTR_STAT, value);
-                    P_STR("RAW_INTR_STAT(0xd): 0x");  P_HEX_W(value); P_CR_LF();
+    t = i2c_queue[i2c_queue_head];
+    i2c_queue_head = (i2c_queue_head + 1) % I2C_QUEUE_LEN;
+    i2c_queue_cnt--;
+
+    i2c_set_tar_register(t->addr);
+    i2c_wr_idx = 0;
+    i2c_rd_req = 0;
+    i2c_rd_idx = 0;
+    i2c_ticks  = 0;
+    t->state   = I2C_TRANS_ACTIVE;
+    i2c_cur    = t;
+
+    /* The TX FIFO is empty, so the first TX_EMPTY event starts the transfer */
+    H2_WRITE(VTSS_TWI_TWI_TX_TL, VTSS_F_TWI_TWI_TX_TL_TX_TL(0));
+    H2_WRITE(VTSS_TWI_TWI_INTR_MASK,
+             VTSS_F_TWI_TWI_INTR_MASK_M_TX_EMPTY | VTSS_F_TWI_TWI_INTR_MASK_M_TX_ABRT);
+}
 
-                    H2_READ(VTSS_TWI_TWI_RX_TL, value);
-                    P_STR("RX_TL(0xe): 0x");  P_HEX_W(value); P_CR_LF();
+/* Release the active transaction once the ISR has finished it */
+static void i2c_complete (void)
+{
+    i2c_trans_t xdata *t = i2c_cur;
 
-                    H2_READ(VTSS_TWI_TWI_TX_TL, value);
-                    P_STR("TX_TL(0xf): 0x");  P_HEX_W(value); P_CR_LF();
+    if (t == XNULL || t->state == I2C_TRANS_ACTIVE) {
+        return;
+    }
 
-                    H2_READ(VTSS_TWI_TWI_CLR_RX_UNDER, value);
-                    P_STR("CLR_RX_UNDER(0x11): 0x");  P_HEX_W(value); P_CR_LF();
+    i2c_cur = XNULL;
+    if (t->client != I2C_CLIENT_NONE) {
+        callback_i2c_done(t->client, t->tag, t->state == I2C_TRANS_DONE);
+    }
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_RX_OVER, value);
-                    P_STR("CLR_RX_OVER(0x12): 0x");  P_HEX_W(value); P_CR_LF();
+/* Give up on the active transaction and recover the controller */
+static void i2c_abort (void)
+{
+    H2_WRITE(VTSS_TWI_TWI_INTR_MASK, 0);
+    i2c_cur->state = I2C_TRANS_FAILED;
+#if I2C_DEBUG
+    print_str("I2C timeout (addr) ");
+    print_dec(i2c_cur->addr);
+    print_cr_lf();
+#endif
 
-                    H2_READ(VTSS_TWI_TWI_CLR_TX_OVER, value);
-                    P_STR("CLR_TX_OVER(0x13): 0x");  P_HEX_W(value); P_CR_LF();
+    /* Recover I2C when errors happen, for example,
+       plug out SFP module when reading I2C data */
+    i2c_init();
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_RD_REQ, value);
-                    P_STR("CLR_RD_REQ(0x14): 0x");  P_HEX_W(value); P_CR_LF();
+/* Encode an EEPROM address as 1 or 2 address bytes, 0 if out of range */
+static uchar i2c_eeprom_addr (ulong mem_addr, uchar *addr)
+{
+    if (mem_addr > 65535) {
+        return 0;
+    } else if (mem_addr > 255) {
+        addr[0] = mem_addr >> 8;
+        addr[1] = mem_addr & 0xff;
+        return 2;
+    }
+    addr[0] = mem_addr;
+    return 1;
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_TX_ABRT, value);
-                    P_STR("CLR_TX_ABRT(0x15): 0x");  P_HEX_W(value); P_CR_LF();
+BOOL i2c_submit (i2c_trans_t xdata *trans)
+{
+    if (i2c_queue_cnt == I2C_QUEUE_LEN || trans->wr_len > I2C_WR_LEN_MAX) {
+        return FALSE;
+    }
 
-                    H2_READ(VTSS_TWI_TWI_CLR_RX_DONE, value);
-                    P_STR("CLR_RX_DONE(0x16): 0x");  P_HEX_W(value); P_CR_LF();
+    trans->state = I2C_TRANS_QUEUED;
+    i2c_queue[(i2c_queue_head + i2c_queue_cnt) % I2C_QUEUE_LEN] = trans;
+    i2c_queue_cnt++;
+    i2c_start_next();
 
-                    H2_READ(VTSS_TWI_TWI_CLR_ACTIVITY, value);
-                    P_STR("CLR_ACTIVITY(0x17): 0x");  P_HEX_W(value); P_CR_LF();
+    return TRUE;
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_STOP_DET, value);
-                    P_STR("CLR_STOP_DET(0x18): 0x");  P_HEX_W(value); P_CR_LF();
+BOOL i2c_eeprom_read_submit (i2c_trans_t xdata *trans, uchar i2c_addr, ushort mem_addr,
+                             uchar xdata *buf, uchar len, uchar client, uchar tag)
+{
+    trans->addr   = i2c_addr;
+    trans->wr_len = i2c_eeprom_addr(mem_addr, &trans->wr_buf[0]);
+    trans->rd_len = len;
+    trans->rd_buf = buf;
+    trans->client = client;
+    trans->tag    = tag;
+    return i2c_submit(trans);
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_START_DET, value);
-                    P_STR("CLR_START_DET(0x19): 0x");  P_HEX_W(value); P_CR_LF();
+void i2c_tsk (void)
+{
+    if (i2c_cur != XNULL && i2c_cur->state == I2C_TRANS_ACTIVE) {
+        if (++i2c_ticks < I2C_TRANS_TIMEOUT) {
+            return;
+        }
+        i2c_abort();
+    }
+    i2c_complete();
+    i2c_start_next();
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_GEN_CALL, value);
-                    P_STR("CLR_GEN_CALL(0x1a): 0x");  P_HEX_W(value); P_CR_LF();
+// ----------------------------------------------------------------------------
+// Blocking access, built on the engine above.
 
-                    H2_READ(VTSS_TWI_TWI_CTRL, value);
-                    P_STR("CTRL(0x1b): 0x");  P_HEX_W(value); P_CR_LF();
+/* Run one transaction and wait for it. Returns TRUE on success. */
+static BOOL i2c_xfer(const uchar i2c_addr,
+                     const uchar *wr_data, uchar wr_len,
+                     uchar *rd_data, uchar rd_len)
+{
+    i2c_trans_t xdata *t = &i2c_sync_trans;
+    uchar i;
 
-                    H2_READ(VTSS_TWI_TWI_STAT, value);
-                    P_STR("STAT(0x1c): 0x");  P_HEX_W(value); P_CR_LF();
+    if (t->state == I2C_TRANS_QUEUED || t->state == I2C_TRANS_ACTIVE ||
+        rd_len > I2C_SYNC_BUF_LEN) {
+        return FALSE;
+    }
 
-                    H2_READ(VTSS_TWI_TWI_TXFLR, value);
-                    P_STR("TXFLR(0x1d): 0x");  P_HEX_W(value); P_CR_LF();
+    t->addr   = i2c_addr;
+    t->wr_len = wr_len;
+    for (i = 0; i < wr_len && i < I2C_WR_LEN_MAX; i++) {
+        t->wr_buf[i] = wr_data[i];
+    }
+    t->rd_len = rd_len;
+    t->rd_buf = &i2c_sync_buf[0];
+    t->client = I2C_CLIENT_NONE;
+    t->tag    = 0;
+    if (!i2c_submit(t)) {
+        return FALSE;
+    }
 
-                    H2_READ(VTSS_TWI_TWI_RXFLR, value);
-                    P_STR("RXFLR(0x1e): 0x");  P_HEX_W(value); P_CR_LF();
+    // Transactions queued ahead of ours are driven here as well, each one
+    // gets 100 ms before the controller is recovered.
+    start_timer(MSEC_100);
+    for (;;) {
+        i2c_complete();
+        if (t->state == I2C_TRANS_DONE || t->state == I2C_TRANS_FAILED) {
+            break;
+        }
+        if (i2c_cur == XNULL) {
+            i2c_start_next();
+            start_timer(MSEC_100);
+        } else if (timeout()) {
+            i2c_abort();
+        }
+    }
 
-                    H2_READ(VTSS_TWI_TWI_TX_ABRT_SOURCE, value);
-                    P_STR("TX_ABRT_SOURCE(0x20): 0x");  P_HEX_W(value); P_CR_LF();
+    if (t->state != I2C_TRANS_DONE) {
+        return FALSE;
+    }
+    for (i = 0; i < rd_len; i++) {
+        rd_data[i] = i2c_sync_buf[i];
+    }
+    return TRUE;
+}
 
-                    H2_READ(VTSS_TWI_TWI_CLR_INTR, value);
-                    P_STR("CLR_INTR(0x10): 0x");  P_HEX_W(value); P_CR_LF();
+ulong i2c_tx(const uchar i2c_addr,
+            const uchar *tx_data,
+            ulong count)
+{
+    /* Sent as one transfer, so a longer write is not split in several
+       that each restart at the address the device sees first */
+    if (count > I2C_WR_LEN_MAX || !i2c_xfer(i2c_addr, tx_data, count, 0, 0)) {
+        return 0;
+    }
+    return count;
+}
 
-                    i2c_init();
-                    return 0;
-                }
-            } while (value == 0);
+ulong i2c_rx(const uchar i2c_addr,
+             uchar* rx_data,
+             ulong count)
+{
+    ulong bytes_recieved = 0;
+    uchar len;
 
-            H2_READ(VTSS_TWI_TWI_DATA_CMD, value);
-            //print_str("value "); print_hex_b(value); print_cr_lf();
-            *rx_data = value & 0xff;
-#if I2C_DEBUG
-            print_dec(i); i++;
-            print_str(" 0x");
-            print_hex_b(*rx_data);
+    while (count > 0) {
+        len = (count > I2C_SYNC_BUF_LEN) ? I2C_SYNC_BUF_LEN : count;
+        if (!i2c_xfer(i2c_addr, 0, 0, rx_data, len)) {
+            print_str("Read TimeOut(Addr) "); print_dec(i2c_addr);
             print_cr_lf();
-#endif
-            rx_data++;
-            bytes_recieved++;
+            return 0;
         }
+        rx_data += len;
+        count -= len;
+        bytes_recieved += len;
     }
-#if 0
-    print_str("bytes_recieved");
-    print_dec(bytes_recieved);
-    H2_READ(VTSS_TWI_TWI_RXFLR, value);
-                print_str("  VTSS_TWI_TWI_RXFLR : ");
-                print_dec(value);
-    print_cr_lf();
-#endif
     return bytes_recieved;
 }
 
@@ -432,26 +510,21 @@ ulong i2c_eeprom_read(const uchar i2c_addr,
                       ulong *mem_addr,
                       uchar *i2c_data)
 {
-    uchar addr_8;
-
-    if (*mem_addr > 65535) {
-      print_str(" addr > 65535 not implemet");
-    } else if (*mem_addr > 255) {
-      addr_8  = (*mem_addr) >> 8;
-      i2c_tx(i2c_addr, &addr_8, 1);
-      addr_8  = (*mem_addr)& 0xff;
-      i2c_tx(i2c_addr, &addr_8, 1);
-    } else {
-      addr_8  = *mem_addr;
-      i2c_tx(i2c_addr, &addr_8, 1);
+    uchar addr[2];
+    uchar len;
+
+    len = i2c_eeprom_addr(*mem_addr, addr);
+    if (len == 0) {
+        print_str(" addr > 65535 not implemet");
+        return FALSE;
     }
 
-    if (i2c_rx(i2c_addr,i2c_data, 1) != 0 ) {
+    /* Address write and read in one transfer (repeated start) */
+    if (i2c_xfer(i2c_addr, addr, len, i2c_data, 1)) {
         return TRUE; // suceess
     } else {
         return FALSE; // fail
     }
-
 }
 
 #endif
@@ -43,12 +43,55 @@
 #ifndef I2C_H_H
 #define I2C_H_H
 
+/* Address bytes one transaction can write before it reads */
+#define I2C_WR_LEN_MAX 8
+
+/* Owner of a transaction, selects the handler in callback_i2c_done() */
+enum {
+    I2C_CLIENT_NONE = 0,   /* Blocking call, nobody to notify */
+    I2C_CLIENT_SFP
+};
+
+/* Transaction states */
+#define I2C_TRANS_IDLE      0
+#define I2C_TRANS_QUEUED    1
+#define I2C_TRANS_ACTIVE    2
+#define I2C_TRANS_DONE      3
+#define I2C_TRANS_FAILED    4
+
+/*
+ * Write wr_len bytes, then read rd_len bytes into rd_buf, as one transfer.
+ * The structure must stay untouched until state is DONE or FAILED.
+ */
+typedef struct {
+    uchar          addr;
+    uchar          wr_len;
+    uchar          wr_buf [I2C_WR_LEN_MAX];
+    uchar          rd_len;
+    uchar xdata    *rd_buf;
+    uchar          client;
+    uchar          tag;
+    volatile uchar state;
+} i2c_trans_t;
+
 //
 // Internal VCOREIII functions
 //
 
 void i2c_init(void);
 
+/* Queue a transaction, FALSE if the queue is full. Completion is reported
+   through callback_i2c_done() from i2c_tsk() */
+BOOL i2c_submit(i2c_trans_t xdata *trans);
+
+/* Queue the read of len bytes at mem_addr of an EEPROM into buf, as
+   i2c_eeprom_read() without waiting. Completion is reported as above */
+BOOL i2c_eeprom_read_submit(i2c_trans_t xdata *trans, uchar i2c_addr, ushort mem_addr,
+                            uchar xdata *buf, uchar len, uchar client, uchar tag);
+void i2c_tsk(void);
+void i2c_interrupt(void) small;
+
+/* Write at most I2C_WR_LEN_MAX bytes, returns 0 for a longer write */
 ulong i2c_tx(const uchar i2c_address,
             const uchar *tx_data,
             ulong count);
@@ -57,7 +100,7 @@ ulong i2c_rx(const uchar i2c_address,
              ulong count);
 ulong i2c_eeprom_read(const uchar i2c_address,
                       ulong *mem_addr,
-                      char *i2c_data);
+                      uchar *i2c_data);
 
 #endif //I2C_H_H
 
@@ -9,6 +9,15 @@
 #include "timer.h"
 #include "uartdrv.h"
 #include "misc2.h"
+#if USE_HW_TWI
+#include "i2c_h.h"
+#endif
+#if USE_FDMA_XTR || USE_FDMA_INJ
+#include "h2fdma.h"
+#endif
+#if USE_XTR_IRQ
+#include "h2txrx.h"
+#endif
 
 /*****************************************************************************
  *
@@ -96,6 +105,9 @@ void ext_1_interrupt (void) small interrupt 2 using 2
  ****************************************************************************/
 {
     ulong ident;
+#if LOOPBACK_TEST
+    ulong access_cnt = h2_access_cnt;
+#endif
     H2_READ(VTSS_ICPU_CFG_INTR_ICPU_IRQ1_IDENT, ident);
 #ifndef NO_DEBUG_IF
     if(test_bit_32(6, &ident)) {
@@ -104,6 +116,9 @@ void ext_1_interrupt (void) small interrupt 2 using 2
         H2_WRITE(VTSS_ICPU_CFG_INTR_INTR, VTSS_F_ICPU_CFG_INTR_INTR_UART_INTR);
     }
 #endif
+#if LOOPBACK_TEST
+    h2_access_cnt = access_cnt;
+#endif
 }
 
 /* ************************************************************************ */
@@ -118,12 +133,38 @@ void ext_0_interrupt (void) small interrupt 0 using 1
  ****************************************************************************/
 {
     ulong ident;
+#if LOOPBACK_TEST
+    ulong access_cnt = h2_access_cnt;
+#endif
     H2_READ(VTSS_ICPU_CFG_INTR_ICPU_IRQ0_IDENT, ident);
     if(test_bit_32(8, &ident)) {
         // Timer 1 interrupt
         timer_1_interrupt();
         H2_WRITE(VTSS_ICPU_CFG_INTR_INTR, VTSS_F_ICPU_CFG_INTR_INTR_TIMER1_INTR);
     }
+#if USE_HW_TWI
+    if(test_bit_32(11, &ident)) {
+        // TWI interrupt
+        i2c_interrupt();
+        H2_WRITE(VTSS_ICPU_CFG_INTR_INTR, VTSS_F_ICPU_CFG_INTR_INTR_TWI_INTR);
+    }
+#endif
+#if USE_FDMA_XTR || USE_FDMA_INJ
+    if(test_bit_32(10, &ident)) {
+        // FDMA interrupt
+        h2_fdma_interrupt();
+        H2_WRITE(VTSS_ICPU_CFG_INTR_INTR, VTSS_F_ICPU_CFG_INTR_INTR_FDMA_INTR);
+    }
+#endif
+#if USE_XTR_IRQ
+    if(test_bit_32(16, &ident) || test_bit_32(17, &ident)) {
+        // Extraction group interrupt, cleared by rx_packet_tsk()
+        h2_rx_interrupt(ident);
+    }
+#endif
+#if LOOPBACK_TEST
+    h2_access_cnt = access_cnt;
+#endif
 }
 
 
@@ -24,9 +24,10 @@
 
 #include "misc2.h"
 #include "i2c_h.h"
-#if UNMANAGED_PORT_STATISTICS_IF
+#if UNMANAGED_PORT_STATISTICS_IF || TRANSIT_STATS_64
 #include "h2stats.h"
 #endif
+#include "h2mactab.h"
 
 #include "taskdef.h"
 
@@ -56,6 +57,10 @@
 #include "poetsk.h"
 #endif /* TRANSIT_POE */
 
+#if TRANSIT_IGMP_SNOOP
+#include "h2igmp.h"
+#endif
+
 #if TRANSIT_POE_LLDP
 #include "poe_os.h"
 #endif
@@ -123,11 +128,17 @@ static void error_check (void)
     if (h2_check() != 0) {
         sysutil_set_fatal_error(H2_GENERAL_FAILURE);
     }
+}
 
-    if (phy_check_all() != 0) {
-        sysutil_set_fatal_error(PHY_GENERAL_FAILURE);
-    }
+/* Check a few PHYs per call instead of all of them every second */
+static void phy_error_check (void)
+{
+    uchar error;
 
+    error = phy_check_next();
+    if (error != 0) {
+        sysutil_set_fatal_error(error);
+    }
 }
 
 
@@ -179,6 +190,9 @@ void main (void)
     flash_init();
 #endif
     flash_load_config();
+#if TRANSIT_BUF_PROFILE
+    h2_buf_profile_set(flash_read_buf_profile());
+#endif
 
     /*
      * Do some health check of chip
@@ -194,6 +208,9 @@ void main (void)
     phy_hw_init();
 
     h2_init_ports();
+#if TRANSIT_STATS_64
+    h2_stats_init();
+#endif
 
     /*
      * Initialize and check PHYs, hang the system if chek not passed.
@@ -230,9 +247,15 @@ void main (void)
     led_init();
 #endif
 
+#if TRANSIT_CPU_POLICING
+    h2_cpu_pol_init();
+#endif
 #if TRANSIT_LLDP || LOOPBACK_TEST
     h2_rx_init();
 #endif
+#if TRANSIT_IGMP_SNOOP
+    h2_igmp_init();
+#endif
 #if TRANSIT_LLDP
     lldp_init();
 #endif /* TRANSIT_LLDP */
@@ -245,8 +268,8 @@ void main (void)
     phy_tsk(); // Activate state machine. We have seen that dual media doesn't pass VeriPhy if state machine is not activated.
     phy_veriphy_all(); //dual media might not pass VeriPhy if there are packets coming to one of the dual-media ports in booting stage.
 #endif
-#if TRANSIT_ACTIPHY
-    phy_actiphy_all();
+#if TRANSIT_ACTIPHY && !TRANSIT_VERIPHY
+    phy_actiphy_all(); /* With VeriPHY enabled after the boot run by phy_veriphy_tsk() */
 #endif
 
 #if TRANSIT_EEE
@@ -295,6 +318,9 @@ void main (void)
         TASK(TASK_ID_RX_PACKET, rx_packet_tsk());
 #endif
 
+        /* Run queued MAC table commands */
+        TASK(TASK_ID_MACTAB_CMD, h2_mactab_cmd_poll());
+
         /*
          * Do 10 msec jobs
          */
@@ -303,10 +329,19 @@ void main (void)
 
             TASK(TASK_ID_PHY_TIMER, phy_timer_10());
             TASK(TASK_ID_PHY, phy_tsk());
+#if USE_HW_TWI
+            TASK(TASK_ID_I2C, i2c_tsk());
+#endif
+#if TRANSIT_VERIPHY
+            TASK(TASK_ID_VERIPHY, phy_veriphy_tsk());
+#endif
 
 #if (WATCHDOG_PRESENT && WATCHDOG_ENABLE)
             TASK(TASK_ID_WATCHDOG, kick_watchdog());
 #endif
+#if TRANSIT_MACTAB_STAT
+            TASK(TASK_ID_MACTAB_SCAN, h2_mactab_scan());
+#endif
 
         }
 
@@ -326,6 +361,10 @@ void main (void)
 #if TRANSIT_EEE
             TASK(TASK_ID_EEE, eee_mgmt());
 #endif
+#if TRANSIT_STATS_64
+            TASK(TASK_ID_STATS_POLL, h2_stats_poll());
+#endif
+            TASK(TASK_ID_PHY_CHECK, phy_error_check());
         }
 
         /*
@@ -354,6 +393,20 @@ void main (void)
              */
             TASK(TASK_ID_ERROR_CHECK, error_check());
 
+#if TRANSIT_CPU_POLICING
+            h2_cpu_pol_1sec();
+#endif
+
+#if TRANSIT_LEARN_LIMIT
+            h2_mactab_learn_1sec();
+#endif
+#if TRANSIT_AGE_ADAPT
+            h2_mactab_age_1sec();
+#endif
+#if TRANSIT_IGMP_SNOOP
+            h2_igmp_1sec();
+#endif
+
 #if TRANSIT_EEE
             callback_delayed_eee_lpi();
 #endif /* TRANSIT_EEE */
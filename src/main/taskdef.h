@@ -11,6 +11,12 @@ typedef enum {
     TASK_ID_CLI,
     TASK_ID_PHY_TIMER,
     TASK_ID_PHY,
+#if TRANSIT_VERIPHY
+    TASK_ID_VERIPHY,
+#endif
+#if USE_HW_TWI
+    TASK_ID_I2C,
+#endif
 
     TASK_ID_UIP_TIMER,
 
@@ -20,6 +26,7 @@ typedef enum {
     TASK_ID_WEB_TIMER,
 
     TASK_ID_ERROR_CHECK,
+    TASK_ID_PHY_CHECK,
 #if (WATCHDOG_PRESENT && WATCHDOG_ENABLE)
     TASK_ID_WATCHDOG,
 #endif
@@ -35,6 +42,13 @@ typedef enum {
 #if TRANSIT_LOOPDETECT
     TASK_ID_LOOPBACK_CHECK,
 #endif
+#if TRANSIT_MACTAB_STAT
+    TASK_ID_MACTAB_SCAN,
+#endif
+#if TRANSIT_STATS_64
+    TASK_ID_STATS_POLL,
+#endif
+    TASK_ID_MACTAB_CMD,
     TASK_ID_RX_PACKET,
 #if TRANSIT_LLDP
     TASK_ID_LLDP_TIMER,
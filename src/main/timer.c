@@ -67,6 +67,10 @@ static bit                  ms_1_timeout_flag       = FALSE;
 
 static ulong xdata          time_since_boot_t       = 0;
 
+#if LOOPBACK_TEST
+static ulong xdata          ms_tick_cnt             = 0;
+#endif /* LOOPBACK_TEST */
+
 #if VTSS_FEATURE_FTIME
 static struct timeb xdata   t_now;
 #endif /* VTSS_FEATURE_FTIME */
@@ -149,6 +153,10 @@ void timer_1_interrupt (void) small
 
     ms_1_timeout_flag = TRUE;
 
+#if LOOPBACK_TEST
+    ms_tick_cnt++;
+#endif /* LOOPBACK_TEST */
+
     if (--ms_1_count == 0) {
         ms_1_count = 10;
 
@@ -273,6 +281,22 @@ ulong time_since_boot_ticks (void)
 }
 #endif
 
+#if LOOPBACK_TEST
+/**
+ * Return the number of msec since timer 1 was started. Used to time the
+ * CPU tx/rx benchmark, wraps after about 49 days.
+ */
+ulong ms_ticks_get (void)
+{
+    ulong ticks;
+
+    EA = 0;
+    ticks = ms_tick_cnt;
+    EA = 1;
+    return ticks;
+}
+#endif /* LOOPBACK_TEST */
+
 
 #if VTSS_FEATURE_FTIME
 void ftime(struct timeb *tp)
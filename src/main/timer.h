@@ -88,6 +88,10 @@ void    time_since_boot_update  (void);
 ulong   time_since_boot_ticks   (void);
 #endif /* TRANSIT_LLDP */
 
+#if LOOPBACK_TEST
+ulong   ms_ticks_get            (void);
+#endif /* LOOPBACK_TEST */
+
 #if VTSS_FEATURE_FTIME
 void    ftime                   (struct timeb *tp);
 #endif /* VTSS_FEATURE_FTIME */
@@ -69,6 +69,9 @@
 static uchar code ecpdset[] = { 0, 5, 9, 12, 14 };
 #define NUM_ECPD_SETTINGS (sizeof(ecpdset)/sizeof(ecpdset[0]))
 
+/* Set when a MIIM command times out or a read fails */
+static bit miim_failed;
+
 
 /*****************************************************************************
  *
@@ -224,6 +227,7 @@ static void phy_await_completed (uchar miim_no) small
     do {
         H2_READ(VTSS_DEVCPU_GCB_MIIM_MII_STATUS(miim_no), dat);
         if(timeout++ > 25) {
+            miim_failed = TRUE;
             break;
         }
     } while(dat & VTSS_F_DEVCPU_GCB_MIIM_MII_STATUS_MIIM_STAT_BUSY);
@@ -322,11 +326,29 @@ ushort phy_read (vtss_port_no_t port_no, uchar reg_no) small
     phy_await_completed(miim_no);
 
     H2_READ(VTSS_DEVCPU_GCB_MIIM_MII_DATA(miim_no), dat);
-    if (dat & VTSS_F_DEVCPU_GCB_MIIM_MII_DATA_MIIM_DATA_SUCCESS(3))
+    if (dat & VTSS_F_DEVCPU_GCB_MIIM_MII_DATA_MIIM_DATA_SUCCESS(3)) {
+        miim_failed = TRUE;
         return 0;
+    }
     return ((ushort) VTSS_X_DEVCPU_GCB_MIIM_MII_DATA_MIIM_DATA_RDDATA(dat));
 }
 
+/**
+ * Read a PHY register and tell whether the MIIM access succeeded.
+ *
+ * @param port_no   The port number to which the PHY is attached.
+ * @param reg_no    the PHY register number (0-31).
+ * @param value     Register value, 0 if the access failed.
+ *
+ * @return TRUE if the MIIM command completed and the PHY answered.
+ */
+BOOL phy_read_checked (vtss_port_no_t port_no, uchar reg_no, ushort *value) small
+{
+    miim_failed = FALSE;
+    *value = phy_read(port_no, reg_no);
+    return !miim_failed;
+}
+
 /**
  * Write to a PHY register.
  *
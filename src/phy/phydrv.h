@@ -236,6 +236,10 @@ typedef struct {
 ushort  phy_read                (const vtss_port_no_t port_no,
                                  const uchar          reg_no) small;
 
+BOOL    phy_read_checked        (vtss_port_no_t       port_no,
+                                 uchar                reg_no,
+                                 ushort               *value) small;
+
 void    phy_write               (const vtss_port_no_t port_no,
                                  const uchar          reg_no,
                                  const u16            value) small;
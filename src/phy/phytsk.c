@@ -3,6 +3,8 @@
 
 
 
+#include <string.h>
+
 #include "common.h"     /* Always include common.h at the first place of user-defined herder files */
 #include "event.h"
 #include "vtss_luton26_reg.h"
@@ -17,8 +19,9 @@
 #include "h2gpios.h"
 #include "h2sdcfg.h"
 #include "h2pcs1g.h"
+#include "main.h"
 #include "h2txrx.h"
-#if FRONT_LED_PRESENT
+#if FRONT_LED_PRESENT || TRANSIT_VERIPHY
 #include "ledtsk.h"
 #endif
 #include "print.h"
@@ -30,6 +33,9 @@
 #if TRANSIT_VERIPHY
 #include "veriphy.h"
 #endif
+#if TRANSIT_THERMAL && TRANSIT_EEE
+#include "eee_api.h"
+#endif
 #if USE_HW_TWI
 #include "i2c_h.h"
 #endif
@@ -59,11 +65,39 @@
 /* define periods in granularity of 10 msec */
 #define POLL_PERIOD_FOR_LINK           10 /* 100 msec */
 
+/* Ports checked per call of phy_check_next(), called every 100 msec. All
+   ports are covered within 1 sec as when they were all checked at once */
+#define HEALTH_PORTS_PER_CHECK          3
+
 #define MAX_THERMAL_PROT_TIME 10 /* 10 sec */
 #define MAX_JUNCTION_TEMP 122
 
+/* Thermal throttling steps, each one includes the ones below it */
+#define THERMAL_STEP_NONE               0
+#define THERMAL_STEP_EEE                1 /* Force EEE/LPI */
+#define THERMAL_STEP_DOWNSHIFT          2 /* Renegotiate 1G links to 100M */
+#define THERMAL_STEP_POWER_DOWN         3 /* Power down ports */
+
+/* Leave a step only when this many degrees below its threshold */
+#define THERMAL_HYSTERESIS              3
+
+/* 1000BASE-T advertisement bits in register 9 */
+#define PHY_REG_9_1000BASE_T       0x0300
+
 #define SFP_TXDISABLE_PIN  15
 
+#if TRANSIT_VERIPHY
+/* Max. number of ports running VeriPHY at the same time on one MIIM bus */
+#define VERIPHY_MAX_ACTIVE_PER_MIIM    12
+/* Give up on a port if VeriPHY is not done within 5 sec (10 msec ticks) */
+#define VERIPHY_TIMEOUT               500
+/* Flag cable faults found by a run from the CLI on the front LEDs for 2 sec (10 msec ticks) */
+#define VERIPHY_LED_TIME              200
+/* Flash the port LEDs 10 times on cable faults found at boot, 100 msec on and off (10 msec ticks) */
+#define VERIPHY_FLASH_CNT              20
+#define VERIPHY_FLASH_TIME             10
+#endif
+
 /*****************************************************************************
  *
  *
@@ -107,16 +141,84 @@ static uchar start_thermal_protect_timer = FALSE;
 static ushort thermal_protect_cnt = 0;
 static port_bit_mask_t led_err_stat = 0;
 
+/* Next port to check and per-port error counters of the health check */
+static uchar health_port_no;
+static uchar xdata health_miim_err_cnt [MAX_PORT];
+static uchar xdata health_sync_loss_cnt [MAX_PORT];
+
 /* Let all PHYs initially be powered down/disabled */
 static port_bit_mask_t phy_enabled = ALL_PORTS;
 
 #if TRANSIT_THERMAL
 static uchar max_protect_temp = MAX_JUNCTION_TEMP;
+
+/* Degrees below max_protect_temp where each step is entered */
+static const uchar code thermal_step_margin [] = {0, 10, 5, 0};
+/* Min. time in sec to stay in a step before moving to the next one */
+static const uchar code thermal_step_dwell [] = {0, 5, 10, MAX_THERMAL_PROT_TIME};
+
+static uchar thermal_step = THERMAL_STEP_NONE;
+static uchar thermal_step_time;
+#if TRANSIT_EEE
+static port_bit_mask_t thermal_eee_mask;
+#endif
+static port_bit_mask_t thermal_downshift_mask;
+
+#define PHY_REG_9_THERMAL(port_no) \
+    (TEST_PORT_BIT_MASK(port_no, &thermal_downshift_mask) ? \
+     (PHY_REG_9_CONFIG & ~PHY_REG_9_1000BASE_T) : PHY_REG_9_CONFIG)
+#else
+#define PHY_REG_9_THERMAL(port_no) PHY_REG_9_CONFIG
 #endif
 
 #if MAC_TO_MEDIA
 uchar mac_if_changed[MAX_PORT];
+#if TRANSIT_SFP_DETECT
+/* MAC interface resolved from the SFP EEPROM, valid while the module stays in */
+static port_bit_mask_t sfp_mac_if_valid;
+static uchar xdata sfp_mac_if [MAX_PORT];
+#if USE_HW_TWI
+/*
+ * The serial ID page of a new module, and for a 1G module the registers of
+ * a copper SFP PHY, are fetched in the background by the TWI engine, so the
+ * port state machine never waits on the bus. One buffer for both pages,
+ * owned by sfp_id_port until it has been used.
+ */
+#define SFP_ID_LEN          48      /* A0h bytes 0-47 cover everything sfp_detect() reads */
+#define SFP_PHY_LEN         44      /* PHY registers 0-21, two bytes each */
+#define SFP_ID_PORT_NONE    0xff
+#define SFP_ID_BUSY         0
+#define SFP_ID_READY        1
+#define SFP_ID_FAILED       2
+#define SFP_ID_NONE         3       /* Page not fetched */
+static i2c_trans_t xdata sfp_id_trans;
+static uchar xdata sfp_id_buf [SFP_ID_LEN + SFP_PHY_LEN];
+static uchar sfp_id_port = SFP_ID_PORT_NONE;
+static uchar sfp_id_status = SFP_ID_NONE;
+static uchar sfp_phy_status = SFP_ID_NONE;
 #endif
+#endif
+#endif
+
+#if TRANSIT_VERIPHY
+/* Ports waiting to start VeriPHY, ports running it, and ports with a result */
+static port_bit_mask_t veriphy_req_mask;
+static port_bit_mask_t veriphy_active_mask;
+static port_bit_mask_t veriphy_done_mask;
+static uchar  xdata veriphy_active_cnt [2];
+static ushort xdata veriphy_ticks [MAX_PORT];
+static veriphy_parms_t xdata veriphy_result [MAX_PORT];
+/* Boot run in progress, and on/off phases and ticks left of its LED flash */
+static bit   veriphy_boot;
+static uchar veriphy_flash_cnt;
+static uchar veriphy_flash_timer;
+#if FRONT_LED_PRESENT
+/* Ports requested since the last LED report, and ports flagged on the LEDs */
+static port_bit_mask_t veriphy_run_mask;
+static port_bit_mask_t veriphy_led_mask;
+static uchar veriphy_led_timer;
+#endif
+#endif /* TRANSIT_VERIPHY */
 
 #define POLARITY_DETECT_FOR_10HDX_MODE
 /****************************************************************************
@@ -329,8 +431,8 @@ static void handle_phy (vtss_port_no_t port_no)
             print_cr_lf();
         }
 #endif
-        /*  Update register 9 with 1000 Mbps advertising */
-        phy_write(port_no, 9, PHY_REG_9_CONFIG);
+        /*  Update register 9 with 1000 Mbps advertising, unless thermally throttled */
+        phy_write(port_no, 9, PHY_REG_9_THERMAL(port_no));
         /* Restart auto-negotiation */
         phy_restart_aneg(port_no);
 
@@ -412,27 +514,6 @@ static void handle_phy (vtss_port_no_t port_no)
 #define SFP_TRAN_CODE      0x06
 
 #if TRANSIT_SFP_DETECT
-#if USE_SW_TWI
-static uchar i2c_read(uchar addr, uchar reg)
-{
-    uchar ack;
-    uchar temp;
-
-    i2c_start();
-    ack = i2c_send_byte(addr << 1);
-    ack = i2c_send_byte(reg & 0xff);
-
-    i2c_start();
-    ack = i2c_send_byte((addr << 1) | 1);
-
-    /* read LS byte */
-    temp = i2c_get_byte(0);
-
-    i2c_stop();
-
-    return temp;
-}
-#endif /* USE_SW_TWI */
 
 /* Enable I2C access and perform a read */
 static uchar sfp_i2c_read(uchar dev, vtss_port_no_t port_no, uchar addr, uchar *const value, uchar cnt)
@@ -444,14 +525,27 @@ static uchar sfp_i2c_read(uchar dev, vtss_port_no_t port_no, uchar addr, uchar *
     if(!phy_map_serdes(port_no))
         return 0;
 #if USE_HW_TWI
-    i2c_tx(dev, &addr, 1);
-    ret = i2c_rx(dev, value, cnt);
+    /* Served from the pages prefetched by sfp_id_prefetch(), a page that
+       could not be read fails as a direct read would */
+    ret = 0;
+    if (port_no == sfp_id_port) {
+        if (dev == 0x50 && sfp_id_status == SFP_ID_READY &&
+            (ushort) addr + cnt <= SFP_ID_LEN) {
+            memcpy(value, &sfp_id_buf[addr], cnt);
+            ret = cnt;
+        } else if (dev == 0x56 && sfp_phy_status == SFP_ID_READY &&
+                   (ushort) addr + cnt <= SFP_PHY_LEN) {
+            memcpy(value, &sfp_id_buf[SFP_ID_LEN + addr], cnt);
+            ret = cnt;
+        }
+    }
 #endif
 #if USE_SW_TWI
     ret = 0;
-    for(c = 0; c < cnt; c++) {
-        *(value + c) = i2c_read(dev, (addr+c));
-        if(*(value + c) != 0xff) ret |= 1;
+    if (i2c_read_page(dev, addr, value, cnt)) {
+        for(c = 0; c < cnt; c++) {
+            if(*(value + c) != 0xff) ret |= 1;
+        }
     }
 #if 0
     for(c = 0; c < cnt; c++) {
@@ -466,9 +560,68 @@ static uchar sfp_i2c_read(uchar dev, vtss_port_no_t port_no, uchar addr, uchar *
     return ret;
 }
 
+#if USE_HW_TWI
+/* Queue the read of len bytes from address 0 of I2C device dev */
+static BOOL sfp_id_submit(vtss_port_no_t port_no, uchar dev, uchar len, uchar xdata *buf)
+{
+    return i2c_eeprom_read_submit(&sfp_id_trans, dev, 0, buf, len, I2C_CLIENT_SFP, port_no);
+}
+
+/*
+ * Start or check the prefetch of a port. Returns FALSE while a page is still
+ * on its way, TRUE when sfp_detect() can run from the pages. A transaction
+ * that cannot be queued is tried again on the next poll.
+ */
+static BOOL sfp_id_prefetch(vtss_port_no_t port_no)
+{
+    if (sfp_id_status == SFP_ID_BUSY || sfp_phy_status == SFP_ID_BUSY) {
+        return FALSE;   /* Also while the page of a removed module finishes */
+    }
+    if (sfp_id_port == port_no) {
+        /* A 1G module of unknown model may be a copper SFP, whose PHY at
+           0x56 tells whether the host side is SGMII or SerDes */
+        if (sfp_id_status == SFP_ID_READY && sfp_phy_status == SFP_ID_NONE &&
+            sfp_id_buf[12] >= 10 && sfp_id_buf[12] <= 22) {
+            if (sfp_id_submit(port_no, 0x56, SFP_PHY_LEN, &sfp_id_buf[SFP_ID_LEN])) {
+                sfp_phy_status = SFP_ID_BUSY;
+            }
+            return FALSE;
+        }
+        return TRUE;
+    }
+    if (sfp_id_port != SFP_ID_PORT_NONE) {
+        return FALSE;   /* Buffer in use by another port */
+    }
+
+    if (sfp_id_submit(port_no, 0x50, SFP_ID_LEN, &sfp_id_buf[0])) {
+        sfp_id_port    = port_no;
+        sfp_id_status  = SFP_ID_BUSY;
+        sfp_phy_status = SFP_ID_NONE;
+    }
+    return FALSE;
+}
+
+void phy_sfp_id_done(vtss_port_no_t port_no, BOOL ok)
+{
+    if (port_no != sfp_id_trans.tag) {
+        return;
+    }
+    if (sfp_id_trans.addr == 0x56) {
+        sfp_phy_status = ok ? SFP_ID_READY : SFP_ID_FAILED;
+    } else {
+        sfp_id_status = ok ? SFP_ID_READY : SFP_ID_FAILED;
+    }
+}
+#endif /* USE_HW_TWI */
+
 #define CuSFP_DET 1
 
-static uchar sfp_detect(vtss_port_no_t port_no)
+/*
+ * Find the MAC interface of the module from its EEPROM and copper PHY.
+ * *read_ok is FALSE if an EEPROM read failed, e.g. as the module was not yet
+ * ready, and the interface returned is only a fallback.
+ */
+static uchar sfp_detect(vtss_port_no_t port_no, BOOL *read_ok)
 {
 #if TRANSIT_LLDP || LOOPBACK_TEST
     uchar *buf = &rx_packet[0];
@@ -481,6 +634,8 @@ static uchar sfp_detect(vtss_port_no_t port_no)
     ulong vendor;
     const char *CuSFPModel[2] = { "AXGT-R1T", "AXGT-R15" };
 
+    *read_ok = TRUE;
+
     /* I2C slave address 0x50 is the SFP EEPORM address and 0x56 is the SFP copper phy */
     if (sfp_i2c_read(0x50, port_no, 12, &buf[0], 1)) {//MSA EERPOM byte[12], rate in unit of 100Mbits/s
         //print_str("sfp rate:");
@@ -500,6 +655,8 @@ static uchar sfp_detect(vtss_port_no_t port_no)
                 } else if (xmemcmp((char *)CuSFPModel[1], (char*)buf, 8) == 0) { /* Axcen SFP_CU_SERDES */
                     return MAC_IF_SERDES;
                 }
+            } else {
+                *read_ok = FALSE;
             }
 
             /* Vender is unknown, then read PHY registers */
@@ -518,6 +675,7 @@ static uchar sfp_detect(vtss_port_no_t port_no)
                             return MAC_IF_SERDES;
                         }
                     }
+                    *read_ok = FALSE;
                 }
                 return MAC_IF_SERDES; /* PHY vendor is unknown */
             } else {
@@ -527,19 +685,19 @@ static uchar sfp_detect(vtss_port_no_t port_no)
             if(sfp_i2c_read(0x50, port_no, SFP_TRAN_CODE, &buf[0], 1)) {
                 if ((buf[0] & 0xf) == 0)
                     return MAC_IF_100FX;
+            } else {
+                *read_ok = FALSE;
             }
         }
     } else {
-#if USE_HW_TWI
-        i2c_tx(0, &buf[0], 1);
-        i2c_rx(0, &buf[0], 1);
-        delay(MSEC_20);
-#endif
+        *read_ok = FALSE;
     }
     return MAC_IF_SERDES; //MAC_IF_NONE;
 #endif
 #if !CuSFP_DET
+    *read_ok = FALSE;
     if(sfp_i2c_read(0x50, port_no, SFP_TRAN_CODE, &buf[0], 1)) {
+        *read_ok = TRUE;
 
         if(&buf[0] == 0xff) {
 #if USE_HW_TWI
@@ -600,6 +758,17 @@ static uchar serdes_port_sfp_detect(vtss_port_no_t port_no)
         }
 #endif
     }
+#if TRANSIT_SFP_DETECT
+    /* Module removed, identify it again when a module is inserted */
+    if (present_l) {
+        WRITE_PORT_BIT_MASK(port_no, 0, &sfp_mac_if_valid);
+#if USE_HW_TWI
+        if (sfp_id_port == port_no) {
+            sfp_id_port = SFP_ID_PORT_NONE;
+        }
+#endif
+    }
+#endif
     return present_l ? 0:1;
 }
 
@@ -614,6 +783,9 @@ static void handle_serdes(vtss_port_no_t port_no)
  ****************************************************************************/
 {
     uchar  mac_if, lm, sfp_existed;
+#if TRANSIT_SFP_DETECT
+    BOOL   sfp_read_ok;
+#endif
 
     switch (phy_state[port_no]) {
 
@@ -627,7 +799,23 @@ static void handle_serdes(vtss_port_no_t port_no)
         sfp_existed = serdes_port_sfp_detect(port_no);
 #if TRANSIT_SFP_DETECT
         if(sfp_existed) {
-            mac_if = sfp_detect(port_no);
+            /* Only read the EEPROM when the module is new, not on relink */
+            if (!TEST_PORT_BIT_MASK(port_no, &sfp_mac_if_valid)) {
+#if USE_HW_TWI
+                if (!sfp_id_prefetch(port_no)) {
+                    break;  /* Check again on the next poll */
+                }
+#endif
+                /* Read again on the next relink if the EEPROM did not answer */
+                sfp_mac_if[port_no] = sfp_detect(port_no, &sfp_read_ok);
+                WRITE_PORT_BIT_MASK(port_no, sfp_read_ok, &sfp_mac_if_valid);
+#if USE_HW_TWI
+                if (sfp_id_port == port_no) {
+                    sfp_id_port = SFP_ID_PORT_NONE;
+                }
+#endif
+            }
+            mac_if = sfp_mac_if[port_no];
         } else {
             mac_if = phy_map_miim_no(port_no) ; //MAC_IF_SERDES;
         }
@@ -853,6 +1041,63 @@ uchar phy_check_all (void)
 }
 
 
+uchar phy_check_next (void)
+{
+    vtss_port_no_t  port_no;
+    uchar           cnt;
+    ushort          value;
+    uchar           error = 0;
+
+    for (cnt = 0; cnt < HEALTH_PORTS_PER_CHECK; cnt++) {
+        port_no = health_port_no;
+        if (++health_port_no >= MAX_PORT) {
+            health_port_no = MIN_PORT;
+        }
+
+        if (phy_map(port_no)) {
+            /* A failed read is only counted, as a read of 0 it fails the ID check */
+            if (!phy_read_checked(port_no, 2, &value) &&
+                health_miim_err_cnt[port_no] < 0xff) {
+                health_miim_err_cnt[port_no]++;
+            }
+#if PHY_ID_CHECK
+            if (value != PHY_OUI_MSB) {
+                error = PHY_GENERAL_FAILURE;
+            }
+#endif
+        }
+#if MAC_TO_MEDIA
+        else if (phy_map_serdes(port_no)) {
+            /* A link reported up must have the PCS in sync */
+            if (TEST_PORT_BIT_MASK(port_no, &phy_link_up_mask) &&
+                !h2_pcs1g_sync_status_get(port_no) &&
+                health_sync_loss_cnt[port_no] < 0xff) {
+                health_sync_loss_cnt[port_no]++;
+            }
+        }
+#endif
+    }
+
+    return error;
+}
+
+
+#ifndef UNMANAGED_REDUCED_DEBUG_IF
+void phy_health_cnt_get (vtss_port_no_t port_no, uchar *miim_err, uchar *sync_loss)
+{
+    *miim_err  = health_miim_err_cnt[port_no];
+    *sync_loss = health_sync_loss_cnt[port_no];
+}
+
+
+void phy_health_cnt_clear (void)
+{
+    memset(health_miim_err_cnt, 0, sizeof(health_miim_err_cnt));
+    memset(health_sync_loss_cnt, 0, sizeof(health_sync_loss_cnt));
+}
+#endif
+
+
 uchar phy_tsk_init (void)
 {
     vtss_port_no_t port_no;
@@ -877,6 +1122,12 @@ void phy_tsk (void)
     uchar  port_no;
 
     for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+#if TRANSIT_VERIPHY
+        /* Leave the PHY alone until VeriPHY is done on it */
+        if (TEST_PORT_BIT_MASK(port_no, &veriphy_active_mask)) {
+            continue;
+        }
+#endif
         if (phy_map(port_no)) {
             handle_phy(port_no);
         }
@@ -891,6 +1142,14 @@ void phy_tsk (void)
 }
 
 
+#if LOOPBACK_TEST || TRANSIT_THERMAL
+void phy_restart (vtss_port_no_t port_no)
+{
+    phy_state[port_no] = phy_init_state(port_no);
+}
+#endif /* LOOPBACK_TEST || TRANSIT_THERMAL */
+
+
 uchar phy_get_link_mode_raw (vtss_port_no_t port_no)
 {
 
@@ -958,103 +1217,269 @@ port_bit_mask_t phy_get_link_mask (void)
  ****************************************************************************/
 
 /**
- * Run veriphy on all ports.
- *
- * @todo Run only on PHY ports.
+ * Release a port that is running VeriPHY, either because it is done or
+ * because it timed out.
  */
-void phy_veriphy_all (void)
+static void veriphy_release (vtss_port_no_t port_no)
 {
-    uchar                   port_no;
-    uchar                   j;
-    uchar                   errors;
-    /* veriphy_parms_t xdata veriphy_parms [MAX_PORT]; */
-    veriphy_parms_t xdata   *veriphy_parms = (veriphy_parms_t *) rx_packet;
-    BOOL                    all_done = FALSE;
-    BOOL                    done;
-    ushort                  timeout = 1500;
-    port_bit_mask_t         port_mask;
-
+    WRITE_PORT_BIT_MASK(port_no, 0, &veriphy_active_mask);
+    veriphy_active_cnt[phy_map_miim_no(port_no)]--;
+    WRITE_PORT_BIT_MASK(port_no, 1, &veriphy_done_mask);
+}
 
-    // Start VeriPhy for all ports
-    port_mask = ALL_PORTS;//The dual-media ports 20-23 might not pass the VeriPHY with RJ45 connected
+/**
+ * Start VeriPHY on as many of the requested ports as the per-MIIM limit
+ * allows. Ports not started stay requested and are started later when
+ * other ports on the same MIIM finish.
+ */
+static void veriphy_start_requested (void)
+{
+    vtss_port_no_t port_no;
+    uchar          miim_no;
 
     for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            /* Read PHY id to determine action */
-            veriphy_start(port_no); // Starting veriphy for selected port(s)
+        if (!TEST_PORT_BIT_MASK(port_no, &veriphy_req_mask)) {
+            continue;
+        }
+        miim_no = phy_map_miim_no(port_no);
+        if (veriphy_active_cnt[miim_no] >= VERIPHY_MAX_ACTIVE_PER_MIIM) {
+            continue;
         }
+        WRITE_PORT_BIT_MASK(port_no, 0, &veriphy_req_mask);
+        WRITE_PORT_BIT_MASK(port_no, 1, &veriphy_active_mask);
+        veriphy_active_cnt[miim_no]++;
+        veriphy_ticks[port_no] = 0;
+        veriphy_start(port_no);
     }
+}
+
+/**
+ * Check whether the last VeriPHY result of a port is invalid or shows a
+ * fault on any pair.
+ */
+static BOOL veriphy_fault (vtss_port_no_t port_no)
+{
+    uchar j;
+
+    if (!veriphy_result[port_no].flags) {
+        return TRUE;
+    }
+    for (j = 0; j < 4; j++) {
+        if (veriphy_result[port_no].stat[j]) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Poll the ports running VeriPHY once, release the ones that are done or
+ * timed out and start pending ones.
+ */
+static void veriphy_poll (void)
+{
+    vtss_port_no_t port_no;
+    BOOL           done;
 
-    // Polling Verphy until Veriphy is done
-    j = 0;
     for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            done = FALSE;
-            while (!done) { 		
-                veriphy_run(port_no, (veriphy_parms + port_no), &done);
-                j++;
-                if (j > 10) {
-                    break;//timeout: 10*10*10ms
-                }
-                delay(10);
-            }
+        if (!TEST_PORT_BIT_MASK(port_no, &veriphy_active_mask)) {
+            continue;
+        }
+        done = FALSE;
+        veriphy_run(port_no, &veriphy_result[port_no], &done);
+        if (done) {
+            veriphy_release(port_no);
+        } else if (++veriphy_ticks[port_no] >= VERIPHY_TIMEOUT) {
+            /* Give up on this port, report result as not valid */
+            vtss_phy_veriphy_running(port_no, TRUE, FALSE);
+            memset(&veriphy_result[port_no], 0, sizeof(veriphy_parms_t));
+            memset(veriphy_result[port_no].loc, 0xff, 4);
+            veriphy_release(port_no);
         }
     }
-    delay(10);
 
-    errors = 0;
+    veriphy_start_requested();
+}
+
+#if FRONT_LED_PRESENT
+/**
+ * Flag cable faults found by a run from the CLI on the front LEDs.
+ */
+static void veriphy_led_report (void)
+{
+    vtss_port_no_t port_no;
+
     for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            /* Status is valid */
-            if(!(veriphy_parms+port_no)->flags) {
-                errors = 1;
-            }
-            /* Status for each pair */
-            for (j = 0; j < 4; j++) {
-                if((veriphy_parms+port_no)->stat[j]) {
-                    /* Set Error Leds */
-                    errors = 1;
-                }
-            }
-            if(errors) break;
+        if (TEST_PORT_BIT_MASK(port_no, &veriphy_run_mask) &&
+            TEST_PORT_BIT_MASK(port_no, &veriphy_done_mask) &&
+            veriphy_fault(port_no)) {
+            WRITE_PORT_BIT_MASK(port_no, 1, &veriphy_led_mask);
+            led_state_set(port2ext(port_no), VTSS_LED_EVENT_CABLE, VTSS_LED_MODE_BLINK_YELLOW);
         }
     }
-    delay(10);
+    veriphy_run_mask = 0;
+    if (veriphy_led_mask) {
+        veriphy_led_timer = VERIPHY_LED_TIME;
+    }
+}
+#endif /* FRONT_LED_PRESENT */
 
+/**
+ * Turn the port LEDs of all PHY ports on or off for the boot fault flash.
+ */
+static void veriphy_flash_set (BOOL on)
+{
+    vtss_port_no_t port_no;
 
-    if (errors) {
-        for (j = 0; j < 10; j++) {
-            for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-                if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (!phy_map(port_no)) {
+            continue;
+        }
+        if (on) {
 #if defined(LUTON26_L25UN)
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_OFF);
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_ON);
+            sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_OFF);
+            sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_ON);
 #else
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_OFF);
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_ON);
+            sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_OFF);
+            sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_ON);
 #endif
-                }
-            }
-            delay(MSEC_100);
-            for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-                if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_OFF);
-                    sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_OFF);
-                }
-            }
-            delay(MSEC_100);
+        } else {
+            sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_OFF);
+            sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_OFF);
         }
     }
-    delay(10);
+}
 
+#if FRONT_LED_PRESENT
+/**
+ * Hand the port LEDs of all PHY ports to the boot fault flash, so led_port()
+ * leaves them alone, or give them back to the normal LED display.
+ */
+static void veriphy_flash_led_hold (BOOL hold)
+{
+    vtss_port_no_t port_no;
 
     for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
-        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no)) {
-            sgpio_output(port_no, VTSS_SGPIO_BIT_0, VTSS_SGPIO_STATE_OFF);
-            sgpio_output(port_no, VTSS_SGPIO_BIT_1, VTSS_SGPIO_STATE_OFF);
+        if (phy_map(port_no) && !TEST_PORT_BIT_MASK(port_no, &veriphy_led_mask)) {
+            led_state_set(port2ext(port_no), VTSS_LED_EVENT_CABLE,
+                          hold ? VTSS_LED_MODE_OFF : VTSS_LED_MODE_NORMAL);
         }
     }
-	
+}
+#endif /* FRONT_LED_PRESENT */
+
+/**
+ * The boot run is done. If a fault is found on any port start flashing the
+ * port LEDs, which is carried on by phy_veriphy_tsk().
+ */
+static void veriphy_boot_report (void)
+{
+    vtss_port_no_t port_no;
+
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (TEST_PORT_BIT_MASK(port_no, &veriphy_done_mask) && veriphy_fault(port_no)) {
+#if FRONT_LED_PRESENT
+            veriphy_flash_led_hold(TRUE);
+#endif
+            veriphy_flash_cnt   = VERIPHY_FLASH_CNT - 1;
+            veriphy_flash_timer = 0;
+            veriphy_flash_set(TRUE);
+            break;
+        }
+    }
+
+#if TRANSIT_ACTIPHY
+    /* Enabled only now, as it was after the boot run in the past */
+    phy_actiphy_all();
+#endif
+}
+
+/**
+ * Start VeriPHY on all PHY ports at boot. The run is carried out by
+ * phy_veriphy_tsk(), which flashes the port LEDs through the SGPIOs if a
+ * fault is found. The ports are left alone by phy_tsk() until they are done.
+ */
+void phy_veriphy_all (void)
+{
+    phy_veriphy_start(ALL_PORTS);//The dual-media ports 20-23 might not pass the VeriPHY with RJ45 connected
+#if FRONT_LED_PRESENT
+    veriphy_run_mask = 0;
+#endif
+    veriphy_boot = TRUE;
+}
+
+void phy_veriphy_start (port_bit_mask_t port_mask)
+{
+    vtss_port_no_t port_no;
+
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (TEST_PORT_BIT_MASK(port_no, &port_mask) && phy_map(port_no) &&
+            !TEST_PORT_BIT_MASK(port_no, &veriphy_active_mask)) {
+            WRITE_PORT_BIT_MASK(port_no, 0, &veriphy_done_mask);
+            WRITE_PORT_BIT_MASK(port_no, 1, &veriphy_req_mask);
+#if FRONT_LED_PRESENT
+            WRITE_PORT_BIT_MASK(port_no, 1, &veriphy_run_mask);
+#endif
+        }
+    }
+    veriphy_start_requested();
+}
+
+void phy_veriphy_tsk (void)
+{
+#if FRONT_LED_PRESENT
+    vtss_port_no_t port_no;
+
+    if (veriphy_led_timer && --veriphy_led_timer == 0) {
+        for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+            if (TEST_PORT_BIT_MASK(port_no, &veriphy_led_mask)) {
+                led_state_set(port2ext(port_no), VTSS_LED_EVENT_CABLE, VTSS_LED_MODE_NORMAL);
+            }
+        }
+        veriphy_led_mask = 0;
+    }
+#endif
+
+    if (veriphy_flash_cnt && ++veriphy_flash_timer >= VERIPHY_FLASH_TIME) {
+        veriphy_flash_timer = 0;
+        veriphy_flash_cnt--;
+        veriphy_flash_set(veriphy_flash_cnt & 1);
+#if FRONT_LED_PRESENT
+        if (!veriphy_flash_cnt) {
+            veriphy_flash_led_hold(FALSE);
+        }
+#endif
+    }
+
+    if (!veriphy_active_mask) {
+        return;
+    }
+
+    veriphy_poll();
+
+    if (!veriphy_active_mask) {
+#if FRONT_LED_PRESENT
+        veriphy_led_report();
+#endif
+        if (veriphy_boot) {
+            veriphy_boot = FALSE;
+            veriphy_boot_report();
+        }
+    }
+}
+
+BOOL phy_veriphy_busy (void)
+{
+    return (veriphy_active_mask || veriphy_req_mask) ? TRUE : FALSE;
+}
+
+BOOL phy_veriphy_result_get (vtss_port_no_t port_no, veriphy_parms_t xdata *parms)
+{
+    if (!TEST_PORT_BIT_MASK(port_no, &veriphy_done_mask)) {
+        return FALSE;
+    }
+    *parms = veriphy_result[port_no];
+    return TRUE;
 }
 #endif /* TRANSIT_VERIPHY */
 
@@ -1113,9 +1538,72 @@ ushort phy_get_sys_temp (void)
 
 
 #if TRANSIT_THERMAL
-void phy_handle_temperature_protect()
+#if TRANSIT_EEE
+/**
+ * Force EEE/LPI on all PHY ports that don't have it enabled, or give the
+ * ports forced by an earlier call their configured mode back.
+ */
+static void thermal_eee_force (BOOL force)
+{
+    uchar port_ext;
+    uchar port_no;
+
+    for (port_ext = 1; port_ext <= NO_OF_PORTS; port_ext++) {
+        port_no = port2int(port_ext);
+        if (!phy_map(port_no)) {
+            continue;
+        }
+        if (force) {
+            if (!read_eee_conf_mode(port_ext - 1)) {
+                WRITE_PORT_BIT_MASK(port_no, 1, &thermal_eee_mask);
+                write_eee_conf_mode(port_ext - 1, TRUE);
+                eee_port_mode_setup(port_no);
+            }
+        } else if (TEST_PORT_BIT_MASK(port_no, &thermal_eee_mask)) {
+            WRITE_PORT_BIT_MASK(port_no, 0, &thermal_eee_mask);
+            write_eee_conf_mode(port_ext - 1, FALSE);
+            eee_port_mode_setup(port_no);
+        }
+    }
+}
+#endif /* TRANSIT_EEE */
+
+/**
+ * Withdraw (or restore) the 1000BASE-T advertisement on all PHY ports, so
+ * links renegotiate to 100 Mbps and keep carrying traffic.
+ */
+static void thermal_downshift (BOOL downshift)
+{
+    uchar port_no;
+
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (!phy_map(port_no)) {
+            continue;
+        }
+        /* Powered down ports pick up the advertisement when enabled again */
+        WRITE_PORT_BIT_MASK(port_no, downshift, &thermal_downshift_mask);
+        if (!TEST_PORT_BIT_MASK(port_no, &phy_enabled)) {
+            continue;
+        }
+        phy_write(port_no, 9, PHY_REG_9_THERMAL(port_no));
+
+        /* Links already running below 1G are left alone */
+        if (downshift && phy_get_link_state(port_no) &&
+            (get_link_mode(port_no) & LINK_MODE_SPEED_MASK) != LINK_MODE_SPEED_1000) {
+            continue;
+        }
+        phy_restart_aneg(port_no);
+    }
+}
+
+/**
+ * Last step: power down ports according to how far the temperature is
+ * above max_protect_temp, and power them up again when the protection
+ * timer expires.
+ */
+static void thermal_power_down (ushort temperatue)
 {
-    ushort temperatue, temp;
+    ushort temp;
     uchar  port_ext;
     uchar  port_no;
     uchar  temp_id;
@@ -1127,8 +1615,6 @@ void phy_handle_temperature_protect()
 
     enable = 1;
 
-    temperatue = phy_get_sys_temp();
-
     temp_id = 0xff;
     if(temperatue >= max_protect_temp) {  /* Temp. over threshold */
         start_thermal_protect_timer = 1;  /* Start the protectioin timer */
@@ -1139,20 +1625,6 @@ void phy_handle_temperature_protect()
             if(temp >= protect_temp[temp_id] && temp < protect_temp[temp_id + 1])
                 break;
         }
-
-        print_str("temp. is ");
-        print_dec(temperatue);
-        print_cr_lf();
-
-#if 0
-        print_str("cur temp. diff = ");
-        print_dec(temp);
-        print_ch('(');
-        print_dec(protect_temp[temp_id]);
-        print_str("), power down ports = ");
-        print_dec(protect_port[temp_id]);
-        print_cr_lf();
-#endif
     }
 
     if(temp_id != 0xff && temp_id < ARRAY_LENGTH(protect_temp)) {
@@ -1215,6 +1687,67 @@ void phy_handle_temperature_protect()
         }
     }
 
+}
+
+/**
+ * Move to a new throttling step, undoing the steps above it or applying
+ * the steps up to it.
+ */
+static void thermal_step_set (uchar step)
+{
+    print_str("thermal step ");
+    print_dec(step);
+    print_cr_lf();
+
+#if TRANSIT_EEE
+    if ((step >= THERMAL_STEP_EEE) != (thermal_step >= THERMAL_STEP_EEE)) {
+        thermal_eee_force(step >= THERMAL_STEP_EEE);
+    }
+#endif
+    if ((step >= THERMAL_STEP_DOWNSHIFT) != (thermal_step >= THERMAL_STEP_DOWNSHIFT)) {
+        thermal_downshift(step >= THERMAL_STEP_DOWNSHIFT);
+    }
+
+    thermal_step = step;
+    thermal_step_time = 0;
+}
+
+void phy_handle_temperature_protect()
+{
+    ushort temperatue;
+    uchar  step;
+
+    temperatue = phy_get_sys_temp();
+
+    if (thermal_step_time < 0xff) {
+        thermal_step_time++;
+    }
+
+    step = thermal_step;
+    if (step < THERMAL_STEP_POWER_DOWN &&
+            temperatue + thermal_step_margin[step + 1] >= max_protect_temp) {
+        /* Give the current step time to work, unless already at the limit */
+        if (step == THERMAL_STEP_NONE || temperatue >= max_protect_temp ||
+                thermal_step_time >= thermal_step_dwell[step]) {
+            print_str("temp. is ");
+            print_dec(temperatue);
+            print_cr_lf();
+            thermal_step_set(step + 1);
+        }
+    } else if (step > THERMAL_STEP_NONE && step < THERMAL_STEP_POWER_DOWN &&
+               temperatue + thermal_step_margin[step] + THERMAL_HYSTERESIS < max_protect_temp &&
+               thermal_step_time >= thermal_step_dwell[step]) {
+        thermal_step_set(step - 1);
+    }
+
+    if (thermal_step == THERMAL_STEP_POWER_DOWN) {
+        thermal_power_down(temperatue);
+        /* All ports are powered up again when the protection timer expires */
+        if (!start_thermal_protect_timer && !led_err_stat) {
+            thermal_step_set(THERMAL_STEP_DOWNSHIFT);
+        }
+    }
+
 #if 0
     if(led_err_stat) {
         print_str("over heat led stat ");
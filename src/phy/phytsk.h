@@ -20,10 +20,44 @@ void   phy_timer_10                 (void);
  */
 uchar  phy_check_all                (void);
 
+/**
+ * Do run-time check on the next few PHY/SerDes ports in turn, so all ports
+ * are covered within 1 sec when called every 100 msec. MIIM failures and
+ * PCS sync loss on ports with link are counted per port; only a PHY ID
+ * mismatch (PHY_ID_CHECK) is an error, as in phy_check_all().
+ *
+ * @return 0 if ok, otherwise the error id (see main.h) to report.
+ */
+uchar  phy_check_next               (void);
+
+#ifndef UNMANAGED_REDUCED_DEBUG_IF
+/**
+ * Get the health check error counters (saturating at 255) of a port.
+ */
+void   phy_health_cnt_get           (vtss_port_no_t port_no, uchar *miim_err, uchar *sync_loss);
+
+/**
+ * Clear the health check error counters of all ports.
+ */
+void   phy_health_cnt_clear         (void);
+#endif
 
-#if LOOPBACK_TEST
+
+#if MAC_TO_MEDIA && TRANSIT_SFP_DETECT && USE_HW_TWI
+/**
+ * Completion of the SFP ID page prefetch started for a port.
+ *
+ * @note Called by callback_i2c_done().
+ */
+void   phy_sfp_id_done              (vtss_port_no_t port_no, BOOL ok);
+#endif /* MAC_TO_MEDIA && TRANSIT_SFP_DETECT && USE_HW_TWI */
+
+#if LOOPBACK_TEST || TRANSIT_THERMAL
+/**
+ * Restart the port state machine, i.e. set up and negotiate the link again.
+ */
 void   phy_restart                  (vtss_port_no_t port_no);
-#endif /* LOOPBACK_TEST */
+#endif /* LOOPBACK_TEST || TRANSIT_THERMAL */
 
 
 /**
@@ -61,14 +95,40 @@ port_bit_mask_t phy_get_link_mask   (void);
 
 
 #if TRANSIT_VERIPHY
+#include "veriphy.h"
 
+/**
+ * Start veriphy on all PHY ports, for use at boot. Returns immediately, the
+ * run is carried out by phy_veriphy_tsk(), which flags cable faults by
+ * flashing the port LEDs through the SGPIOs (and enables ActiPHY after it).
+ */
+void   phy_veriphy_all              (void);
+
+/**
+ * Request veriphy on the PHY ports in port_mask. Returns immediately, the
+ * run is carried out by phy_veriphy_tsk(), which flags cable faults on the
+ * front LEDs when all ports are done.
+ */
+void   phy_veriphy_start            (port_bit_mask_t port_mask);
+
+/**
+ * Poll ports running veriphy and start pending ones. To be called every
+ * 10 msec (approximately).
+ */
+void   phy_veriphy_tsk              (void);
 
 /**
- * Run veriphy on all ports.
+ * Check if veriphy is still pending or running on any port.
+ */
+BOOL   phy_veriphy_busy             (void);
+
+/**
+ * Get the result of the last veriphy run on a port.
  *
- * @todo Run only on PHY ports.
+ * @return TRUE     If a result is available and has been copied to parms.
+ * @return FALSE    If veriphy has never completed on the port or is running.
  */
-void   phy_veriphy_all              (void);
+BOOL   phy_veriphy_result_get       (vtss_port_no_t port_no, veriphy_parms_t xdata *parms);
 
 
 #endif /* TRANSIT_VERIPHY */
@@ -89,13 +149,23 @@ ushort phy_get_sys_temp             (void);
 
 #if TRANSIT_THERMAL
 /**
- * State machine for temperature monitor. Monitor and set up switch port.
+ * State machine for temperature monitor. To be called every second.
+ *
+ * As the temperature approaches the max. junction temperature, throttling
+ * is applied in steps: force EEE/LPI, downshift 1G links to 100M and at
+ * last power down ports. A step is left with hysteresis and after a
+ * minimum dwell time.
  */
 void phy_handle_temperature_protect (void);
 
 
 void phy_temperature_timer_1sec     (void);
 
+/**
+ * Power up (status TRUE) or down (status FALSE) a port.
+ */
+void phy_set_enable                 (vtss_port_no_t port_no, uchar status);
+
 
 #endif /* TRANSIT_THERMAL */
 
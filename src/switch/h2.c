@@ -21,6 +21,8 @@
 #include "hwport.h"
 #include "h2mactab.h"
 #include "h2vlan.h"
+#include "h2bufcfg.h"
+#include <string.h>
 
 #define VTSS_COMMON_ASSERT(EXPR) /* Go away */
 
@@ -78,6 +80,8 @@ enum {
  *
  ****************************************************************************/
 
+static uchar xdata buf_profile = BUF_PROFILE_DEFAULT;
+static uchar xdata buf_port_speed [MAX_PORT];   /* BUF_SPEED_xxx of each port */
 
 /*****************************************************************************
  *
@@ -111,68 +115,57 @@ static void _h2_setup_cpu_if (void) small
 }
 
 
-static void _l26_buf_conf_set(void)
+/*
+ * Write the watermarks of the buffer profile for the current link speeds.
+ * The queue reservations only change with the profile, so they are left
+ * alone on link changes.
+ */
+static void _l26_buf_wm_set (bool queues)
 {
-    ulong port_no, q, dp, i = 0;
-    ulong buf_q_rsrv_i, buf_q_rsrv_e, ref_q_rsrv_i, ref_q_rsrv_e, buf_prio_shr_i[8], buf_prio_shr_e[8], ref_prio_shr_i[8], ref_prio_shr_e[8];
-    ulong buf_p_rsrv_i, buf_p_rsrv_e, ref_p_rsrv_i, ref_p_rsrv_e, buf_col_shr_i, buf_col_shr_e, ref_col_shr_i, ref_col_shr_e;
-    ulong prio_mem_rsrv, prio_ref_rsrv, mem, ref, value;
-
-    /*  SYS::RES_CFG : 1024 watermarks for 512 kB shared buffer, unit is 48 byte */
-    /*  Is divided into 4 resource consumptions, ingress and egress memory (BUF) and frame reference (REF) blocks */
-
-    /* BUF_xxx_Ingress starts @ offset 0   */
-    /* REF_xxx_Ingress starts @ offset 256 */
-    /* BUF_xxx_Egress  starts @ offset 512 */
-    /* BUF_xxx_Egress  starts @ offset 768 */
-    /* xxx = q_rsrv, prio_shr, p_rsrv, col_shr */
+    buf_cfg_t xdata cfg;
+    uchar     xdata port_cnt [BUF_SPEED_CNT];
+    ushort    port_no, q, res, base;
 
-    /* Queue reserved (q_rsrv) : starts @ offset 0 within in each BUF and REF */
-    /* Prio shared (prio_shr)  : starts @ offset 216 within in each BUF and REF */
-    /* Port reserved (p_rsrv)  : starts @ offset 224 within in each BUF and REF */
-    /* Colour shared (col_shr) : starts @ offset 254 within in each BUF and REF */
-
-    /* WM values  */
-    buf_q_rsrv_i = 10;     /* 500/48 Guarantees reception of at least one frame to all queues  */
-    ref_q_rsrv_i = 8;      /* 4 frames can be pending at each ingress port              */
-    buf_q_rsrv_e = 4;      /* 200/48 Guarantees all priorities to non-congested traffic stream */
-    ref_q_rsrv_e = 8;      /* 4 frames can be pending to each egress port               */
-
-    prio_mem_rsrv = 7000;
-    prio_ref_rsrv = 50;
-
-    /* Subtract the reserved amount from the total amount */
-    mem = 512000-(MAX_PORT + 1)*(0+10000+8*500+8*200);
-    ref = 5500-(MAX_PORT + 1)*(20+20+8*8+8*8);
-
-#ifndef VTSS_PRIOS
-#define VTSS_PRIOS 8
-#endif
+    memset(port_cnt, 0, sizeof(port_cnt));
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        port_cnt[buf_port_speed[port_no]]++;
+    }
+    port_cnt[BUF_SPEED_1G]++; /* The CPU port */
+    h2_buf_cfg_calc(buf_profile, port_cnt, &cfg);
+
+    for (res = 0; res < BUF_RES_CNT; res++) {
+        base = res * 256;
+
+        /* Configure reserved space for all QoS classes per port */
+        if (queues) {
+            for (port_no = MIN_PORT; port_no <= MAX_PORT; port_no++) {
+                for (q = 0; q < BUF_PRIOS; q++) {
+                    H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(base + BUF_WM_Q_RSRV + port_no * BUF_PRIOS + q),
+                             cfg.q_rsrv[res]);
+                }
+            }
+        }
 
-    for (q = 0; q < VTSS_PRIOS; q++) {
-        value = (mem-(7-q)*prio_mem_rsrv)/48;
-        if (value >= 1024) {
-            value = 1024 + value/16;
+        /* Configure shared space for all QoS classes */
+        for (q = 0; q < BUF_PRIOS; q++) {
+            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(base + BUF_WM_PRIO_SHR + q), cfg.prio_shr[res][q]);
         }
-        buf_prio_shr_i[q] = value;
-        ref_prio_shr_i[q] = ref-(7-q)*prio_ref_rsrv;
-        value = (mem-(7-q)*prio_mem_rsrv)/48;
-        if (value >= 1024) {
-            value = 1024 + value/16;
+
+        /* Configure reserved space for all ports, the CPU port as 1 Gbps */
+        for (port_no = MIN_PORT; port_no <= MAX_PORT; port_no++) {
+            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(base + BUF_WM_P_RSRV + port_no),
+                     cfg.p_rsrv[res][port_no < MAX_PORT ? buf_port_speed[port_no] : BUF_SPEED_1G]);
         }
-        buf_prio_shr_e[q] = value;
-        ref_prio_shr_e[q] = ref-(7-q)*prio_ref_rsrv;
     }
+}
 
-    buf_p_rsrv_i = 0;        /* No quaranteed extra space for ingress ports         */
-    ref_p_rsrv_i = 20;       /* 20 extra frames can be pending shared between prios */
-    buf_p_rsrv_e = 10000/48; /* 10kB reserved for each egress port                  */
-    ref_p_rsrv_e = 20;       /* 20 extra frames can be pending shared between prios */
+static void _l26_buf_conf_set(void)
+{
+    ushort i, dp;
 
-    buf_col_shr_i = 0x7FF; /* WM max - never reached */
-    ref_col_shr_i = 0x7FF; /* WM max - never reached */
-    buf_col_shr_e = 0x7FF; /* WM max - never reached */
-    ref_col_shr_e = 0x7FF; /* WM max - never reached */
+    /*  SYS::RES_CFG : 1024 watermarks for 512 kB shared buffer, unit is 48 byte */
+    /*  Is divided into 4 resource consumptions, ingress and egress memory (BUF) and frame reference (REF) blocks */
+    /*  The watermarks of each block are computed by h2_buf_cfg_calc(), see h2bufcfg.h */
 
     i = 0;
     do { /* Reset default WM */
@@ -180,46 +173,30 @@ static void _l26_buf_conf_set(void)
         i++;
     } while (i<1024);
 
-    /* Configure reserved space for all QoS classes per port */
-    for (port_no = MIN_PORT; port_no <= MAX_PORT; port_no++) {
-        for (q = 0; q < VTSS_PRIOS; q++) {
-            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no * VTSS_PRIOS + q + 0),   buf_q_rsrv_i);
-            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no * VTSS_PRIOS + q + 256), ref_q_rsrv_i);
-            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no * VTSS_PRIOS + q + 512), buf_q_rsrv_e);
-            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no * VTSS_PRIOS + q + 768), ref_q_rsrv_e);
-        }
-    }
-
-    /* Configure shared space for all QoS classes */
-    for (q = 0; q < VTSS_PRIOS; q++) {
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG((q + 216 + 0)),   buf_prio_shr_i[q]);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG((q + 216 + 256)), ref_prio_shr_i[q]);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG((q + 216 + 512)), buf_prio_shr_e[q]);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG((q + 216 + 768)), ref_prio_shr_e[q]);
-        H2_READ(VTSS_SYS_RES_CTRL_RES_CFG((q + 216 + 0)),   dp);
-    }
-
-    /* Configure reserved space for all ports */
-    for (port_no = MIN_PORT; port_no <= MAX_PORT; port_no++) {
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no + 224 +   0), buf_p_rsrv_i);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no + 224 + 256), ref_p_rsrv_i);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no + 224 + 512), buf_p_rsrv_e);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(port_no + 224 + 768), ref_p_rsrv_e);
-    }
+    /* All ports are down until the PHYs are set up */
+    memset(buf_port_speed, BUF_SPEED_DOWN, sizeof(buf_port_speed));
+    _l26_buf_wm_set(TRUE);
 
     /* Configure shared space for  both DP levels (green:0 yellow:1) */
     for (dp = 0; dp < 2; dp++) {
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(dp + 254 +   0), buf_col_shr_i);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(dp + 254 + 256), ref_col_shr_i);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(dp + 254 + 512), buf_col_shr_e);
-        H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(dp + 254 + 768), ref_col_shr_e);
+        for (i = 0; i < BUF_RES_CNT; i++) {
+            H2_WRITE(VTSS_SYS_RES_CTRL_RES_CFG(i * 256 + BUF_WM_COL_SHR + dp), 0x7FF); /* WM max - never reached */
+        }
     }
-    return;
 }
 
 
 static void _setup_port (uchar port_no, uchar link_mode)
 {
+    uchar speed;
+
+    /* Recompute the watermarks when the port changes speed class */
+    speed = link_mode == LINK_MODE_DOWN ? BUF_SPEED_DOWN : (link_mode & LINK_MODE_SPEED_MASK) + 1;
+    if (buf_port_speed[port_no] != speed) {
+        buf_port_speed[port_no] = speed;
+        _l26_buf_wm_set(FALSE);
+    }
+
     if (link_mode != LINK_MODE_DOWN) {
 
         /* Set max frame length */
@@ -504,6 +481,9 @@ void h2_post_reset (void)
     delay(MSEC_40);
 
     h2_mactab_agetime_set();
+#if TRANSIT_LEARN_LIMIT
+    h2_mactab_learn_limit_init();
+#endif
 
     _l26_buf_conf_set();
 
@@ -541,6 +521,29 @@ void h2_init_ports (void)
 }
 
 
+#if TRANSIT_BUF_PROFILE
+/**
+ * Select the buffer profile, BUF_PROFILE_xxx of h2bufcfg.h. Others, e.g.
+ * BUF_PROFILE_UNSET, select BUF_PROFILE_DEFAULT of swconf.h.
+ */
+void h2_buf_profile_set (uchar profile)
+{
+    if (profile >= BUF_PROFILE_CNT) {
+        profile = BUF_PROFILE_DEFAULT;
+    }
+    if (profile != buf_profile) {
+        buf_profile = profile;
+        _l26_buf_wm_set(TRUE);
+    }
+}
+
+uchar h2_buf_profile_get (void)
+{
+    return buf_profile;
+}
+#endif /* TRANSIT_BUF_PROFILE */
+
+
 /**
  * Set up port including MAC according to link_mode parameter.
  *
@@ -38,6 +38,10 @@ void                h2_post_reset           (void);
 void                h2_init_ports           (void);
 void                h2_setup_mac            (uchar port_no, link_mode);
 void                h2_setup_port           (uchar port_no, uchar link_mode);
+#if TRANSIT_BUF_PROFILE
+void                h2_buf_profile_set      (uchar profile);
+uchar               h2_buf_profile_get      (void);
+#endif
 
 uchar               h2_check                (void) small;
 void                h2_enable_exc_col_drop  (uchar port_no, uchar drop_enable);
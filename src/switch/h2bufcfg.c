@@ -0,0 +1,162 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+
+#ifndef BUFCALC_HOST
+#include "common.h"     /* Always include common.h at the first place of user-defined herder files */
+#endif
+#include "h2bufcfg.h"
+
+/*****************************************************************************
+ *
+ *
+ * Defines
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Frame references, the same in all profiles */
+#define BUF_REF_SIZE        5500    /* References of the switch */
+#define BUF_REF_Q_RSRV      8       /* Frames pending per queue */
+#define BUF_REF_P_RSRV      20      /* Extra frames pending per port, shared between prios */
+#define BUF_REF_PRIO_STEP   50      /* Shared references held back per lower priority */
+
+/*****************************************************************************
+ *
+ *
+ * Typedefs and enums
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* A profile, the sizes in bytes */
+typedef struct {
+    ushort q_rsrv_i;                    /* Each ingress queue */
+    ushort q_rsrv_e;                    /* Each egress queue */
+    ushort p_rsrv_e [BUF_SPEED_CNT];    /* Each egress port, by its speed */
+    ushort prio_step;                   /* Shared memory held back per lower priority */
+    ushort shared_max;                  /* kB the shared memory is capped at, 0 for none */
+} buf_profile_t;
+
+/*****************************************************************************
+ *
+ *
+ * Local data
+ *
+ *
+ *
+ ****************************************************************************/
+
+static code buf_profile_t buf_profile_tab [BUF_PROFILE_CNT] = {
+    /* Balanced: 10 kB per egress port whatever its speed */
+    { 500, 200, { 10000, 10000, 10000, 10000, 10000 }, 7000, 0 },
+
+    /* Burst: reservations by speed, more than twice the balanced shared
+       memory left to absorb incast */
+    { 200, 200, { 1600, 1600, 1600, 6400, 12800 }, 1600, 0 },
+
+    /* Low latency: 48 kB shared is 0.4 msec of queueing at 1 Gbps, and
+       each queue keeps a 500 byte reservation for e.g. voice */
+    { 500, 500, { 1600, 1600, 3200, 4800, 9600 }, 4000, 48 },
+
+    /* Jumbo: a jumbo frame per egress port with link */
+    { 200, 200, { 1600, JUMBO_SIZE, JUMBO_SIZE, JUMBO_SIZE, JUMBO_SIZE }, JUMBO_SIZE / 2, 0 },
+};
+
+#if defined(BUFCALC_HOST) || (TRANSIT_BUF_PROFILE && LUTON_UNMANAGED_CONF_IF)
+static code char * code buf_profile_txt [BUF_PROFILE_CNT] = {
+    "balanced", "burst", "low-latency", "jumbo"
+};
+#endif
+
+/* Encode a watermark, values from 1024 are in units of 16 */
+static ushort buf_wm_encode (ulong value)
+{
+    if (value >= 1024) {
+        value = 1024 + value / 16;
+        if (value > 0x7ff) {
+            value = 0x7ff;
+        }
+    }
+    return (ushort) value;
+}
+
+/* ************************************************************************ */
+void h2_buf_cfg_calc (uchar profile, const uchar xdata *port_cnt, buf_cfg_t xdata *cfg)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Compute the RES_CFG watermarks of a buffer profile.
+ * Remarks     : port_cnt[] is the number of ports, including the CPU port,
+ *               of each BUF_SPEED_xxx. The reservations of all ports are
+ *               subtracted from the buffer memory, and the rest is shared
+ *               between the priorities, each lower priority getting
+ *               prio_step less of it. The ingress and egress shared
+ *               watermarks are the same. Unknown profiles are taken as
+ *               BUF_PROFILE_BALANCED.
+ * Restrictions: No register access, also built for tools/bufcalc.c.
+ * See also    : _l26_buf_conf_set()
+ * Example     :
+ ****************************************************************************/
+{
+    code buf_profile_t *prof;
+    ulong mem;
+    ulong rsrv;
+    ulong step;
+    ulong ref;
+    uchar ports;
+    uchar speed;
+    uchar q;
+
+    if (profile >= BUF_PROFILE_CNT) {
+        profile = BUF_PROFILE_BALANCED;
+    }
+    prof = &buf_profile_tab[profile];
+
+    /* Subtract the reserved amount from the total amount */
+    for (speed = 0, ports = 0, rsrv = 0; speed < BUF_SPEED_CNT; speed++) {
+        ports += port_cnt[speed];
+        rsrv  += (ulong) port_cnt[speed] *
+                 (BUF_PRIOS * ((ulong) prof->q_rsrv_i + prof->q_rsrv_e) + prof->p_rsrv_e[speed]);
+    }
+    mem = rsrv < BUF_MEM_SIZE ? BUF_MEM_SIZE - rsrv : 0;
+    if (prof->shared_max && mem > prof->shared_max * 1024UL) {
+        mem = prof->shared_max * 1024UL;
+    }
+    cfg->shared = mem;
+
+    rsrv = (ulong) ports * (2 * BUF_REF_P_RSRV + 2 * BUF_PRIOS * BUF_REF_Q_RSRV);
+    ref  = rsrv < BUF_REF_SIZE ? BUF_REF_SIZE - rsrv : 0;
+
+    for (q = 0; q < BUF_PRIOS; q++) {
+        step = (BUF_PRIOS - 1 - q) * (ulong) prof->prio_step;
+        cfg->prio_shr[BUF_RES_BUF_I][q] = buf_wm_encode(mem > step ? (mem - step) / 48 : 0);
+        cfg->prio_shr[BUF_RES_BUF_E][q] = cfg->prio_shr[BUF_RES_BUF_I][q];
+        step = (BUF_PRIOS - 1 - q) * (ulong) BUF_REF_PRIO_STEP;
+        cfg->prio_shr[BUF_RES_REF_I][q] = buf_wm_encode(ref > step ? ref - step : 0);
+        cfg->prio_shr[BUF_RES_REF_E][q] = cfg->prio_shr[BUF_RES_REF_I][q];
+    }
+
+    cfg->q_rsrv[BUF_RES_BUF_I] = buf_wm_encode(prof->q_rsrv_i / 48);
+    cfg->q_rsrv[BUF_RES_REF_I] = BUF_REF_Q_RSRV;
+    cfg->q_rsrv[BUF_RES_BUF_E] = buf_wm_encode(prof->q_rsrv_e / 48);
+    cfg->q_rsrv[BUF_RES_REF_E] = BUF_REF_Q_RSRV;
+
+    for (speed = 0; speed < BUF_SPEED_CNT; speed++) {
+        cfg->p_rsrv[BUF_RES_BUF_I][speed] = 0; /* No guaranteed extra space for ingress ports */
+        cfg->p_rsrv[BUF_RES_REF_I][speed] = BUF_REF_P_RSRV;
+        cfg->p_rsrv[BUF_RES_BUF_E][speed] = buf_wm_encode(prof->p_rsrv_e[speed] / 48);
+        cfg->p_rsrv[BUF_RES_REF_E][speed] = BUF_REF_P_RSRV;
+    }
+}
+
+#if defined(BUFCALC_HOST) || (TRANSIT_BUF_PROFILE && LUTON_UNMANAGED_CONF_IF)
+const char *h2_buf_profile_name (uchar profile)
+{
+    if (profile >= BUF_PROFILE_CNT) {
+        return "unknown";
+    }
+    return buf_profile_txt[profile];
+}
+#endif
@@ -0,0 +1,66 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+#ifndef __H2BUFCFG_H__
+#define __H2BUFCFG_H__
+
+#ifdef BUFCALC_HOST
+/* Built on a PC by tools/bufcalc.c, without the 8051 headers */
+typedef unsigned char   uchar;
+typedef unsigned short  ushort;
+typedef unsigned long   ulong;
+#define code
+#define xdata
+#define JUMBO_SIZE      9600
+#else
+#include "common.h"
+#endif
+
+/* Buffer profiles of h2_buf_cfg_calc() */
+#define BUF_PROFILE_BALANCED    0   /* 10 kB per egress port, as before the profiles */
+#define BUF_PROFILE_BURST       1   /* Small reservations, a deep shared buffer */
+#define BUF_PROFILE_LOW_LATENCY 2   /* Short queues, the shared buffer is capped */
+#define BUF_PROFILE_JUMBO       3   /* A jumbo frame reserved per egress port */
+#define BUF_PROFILE_CNT         4
+#define BUF_PROFILE_UNSET       0xff    /* Not in the flash configuration */
+
+/* Link speed classes of the ports, LINK_MODE_SPEED_xxx + 1 */
+#define BUF_SPEED_DOWN          0
+#define BUF_SPEED_10M           1
+#define BUF_SPEED_100M          2
+#define BUF_SPEED_1G            3
+#define BUF_SPEED_2500M         4
+#define BUF_SPEED_CNT           5
+
+/* The 4 blocks of 256 watermarks in SYS:RES_CTRL:RES_CFG */
+#define BUF_RES_BUF_I           0   /* Ingress memory, in units of 48 bytes */
+#define BUF_RES_REF_I           1   /* Ingress frame references */
+#define BUF_RES_BUF_E           2   /* Egress memory */
+#define BUF_RES_REF_E           3   /* Egress frame references */
+#define BUF_RES_CNT             4
+
+/* Watermarks within a block */
+#define BUF_WM_Q_RSRV           0   /* + port * BUF_PRIOS + prio */
+#define BUF_WM_PRIO_SHR         216 /* + prio */
+#define BUF_WM_P_RSRV           224 /* + port */
+#define BUF_WM_COL_SHR          254 /* + dp */
+#define BUF_PRIOS               8
+
+/* Buffer memory of the switch, in bytes */
+#define BUF_MEM_SIZE            512000UL
+
+/* Encoded watermarks, as written to RES_CFG */
+typedef struct {
+    ushort q_rsrv   [BUF_RES_CNT];                  /* Each queue of a port */
+    ushort prio_shr [BUF_RES_CNT][BUF_PRIOS];       /* Shared per priority */
+    ushort p_rsrv   [BUF_RES_CNT][BUF_SPEED_CNT];   /* Each port, by its speed */
+    ulong  shared;                                  /* Bytes left to share */
+} buf_cfg_t;
+
+void   h2_buf_cfg_calc (uchar profile, const uchar xdata *port_cnt, buf_cfg_t xdata *cfg);
+#if defined(BUFCALC_HOST) || (TRANSIT_BUF_PROFILE && LUTON_UNMANAGED_CONF_IF)
+const char *h2_buf_profile_name (uchar profile);
+#endif
+
+#endif
@@ -0,0 +1,812 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+
+#include "common.h"     /* Always include common.h at the first place of user-defined herder files */
+
+#if USE_FDMA_XTR || USE_FDMA_INJ
+#include <string.h>
+#include "vtss_luton26_regs.h"
+#include "h2io.h"
+#include "h2packet.h"
+#include "h2fdma.h"
+#include "misc2.h"
+
+/*****************************************************************************
+ *
+ *
+ * Defines
+ *
+ *
+ *
+ ****************************************************************************/
+
+/*
+ * Each extraction group is served by the FDMA channel with the same number,
+ * injection uses the channel after those. The DCBs of a channel form a
+ * linked list in SBA RAM that is used as a ring: a DCB is unlinked when it
+ * has been consumed and appended after the tail.
+ */
+#define FDMA_XTR_CH(grp)    (grp)
+#define FDMA_XTR_CH_MASK    ((1 << VTSS_PACKET_RX_GROUP_CNT) - 1)
+#define FDMA_INJ_CH         VTSS_PACKET_RX_GROUP_CNT
+#define FDMA_INJ_CH_MASK    (1 << FDMA_INJ_CH)
+
+#define FDMA_XTR_DCB_CNT    8       /* DCBs and frame buffers per group */
+#define FDMA_INJ_DCB_CNT    8
+#define FDMA_BUF_SIZE       1600UL  /* IFH + largest frame, incl. FCS */
+#define FDMA_XTR_MAX_LENGTH (RECV_BUFSIZE+2)
+
+/* DCB numbers, extraction rings first */
+#define FDMA_XTR_DCB(grp, i) ((grp) * FDMA_XTR_DCB_CNT + (i))
+#define FDMA_INJ_DCB(i)      (VTSS_PACKET_RX_GROUP_CNT * FDMA_XTR_DCB_CNT + (i))
+
+/* DCB layout as fetched and written back by the DMA controller */
+#define FDMA_DCB_SIZE       28UL
+#define FDMA_DCB_SAR        0
+#define FDMA_DCB_DAR        4
+#define FDMA_DCB_LLP        8
+#define FDMA_DCB_CTL0       12
+#define FDMA_DCB_CTL1       16
+#define FDMA_DCB_SSTAT      20
+
+/* The DCBs come first, the frame buffers start at offset 0x400 */
+#define FDMA_DCB_ADDR(n)    (FDMA_RAM_BASE + (n) * FDMA_DCB_SIZE)
+#define FDMA_BUF_ADDR(n)    (FDMA_RAM_BASE + 0x400UL + (n) * FDMA_BUF_SIZE)
+
+/* Peripheral to memory with the extraction group as flow controller, in
+   bursts of 16 words (must match XTR_BURST_SIZE) */
+#define FDMA_XTR_CTL0 (VTSS_F_FDMA_CH_CTL0_LLP_SRC_EN      | \
+                       VTSS_F_FDMA_CH_CTL0_LLP_DST_EN      | \
+                       VTSS_F_FDMA_CH_CTL0_TT_FC(4)        | \
+                       VTSS_F_FDMA_CH_CTL0_SRC_MSIZE(3)    | \
+                       VTSS_F_FDMA_CH_CTL0_DEST_MSIZE(3)   | \
+                       VTSS_F_FDMA_CH_CTL0_SINC(2)         | \
+                       VTSS_F_FDMA_CH_CTL0_DINC(0)         | \
+                       VTSS_F_FDMA_CH_CTL0_SRC_TR_WIDTH(2) | \
+                       VTSS_F_FDMA_CH_CTL0_DST_TR_WIDTH(2) | \
+                       VTSS_F_FDMA_CH_CTL0_INT_EN)
+#define FDMA_XTR_CTL1 VTSS_F_FDMA_CH_CTL1_BLOCK_TS(FDMA_BUF_SIZE / 4)
+
+/* Memory to peripheral with the DMA as flow controller, one frame per DCB */
+#define FDMA_INJ_CTL0 (VTSS_F_FDMA_CH_CTL0_LLP_SRC_EN      | \
+                       VTSS_F_FDMA_CH_CTL0_LLP_DST_EN      | \
+                       VTSS_F_FDMA_CH_CTL0_TT_FC(1)        | \
+                       VTSS_F_FDMA_CH_CTL0_SRC_MSIZE(3)    | \
+                       VTSS_F_FDMA_CH_CTL0_DEST_MSIZE(3)   | \
+                       VTSS_F_FDMA_CH_CTL0_SINC(0)         | \
+                       VTSS_F_FDMA_CH_CTL0_DINC(2)         | \
+                       VTSS_F_FDMA_CH_CTL0_SRC_TR_WIDTH(2) | \
+                       VTSS_F_FDMA_CH_CTL0_DST_TR_WIDTH(2) | \
+                       VTSS_F_FDMA_CH_CTL0_INT_EN)
+
+/* Handshaking interfaces 0-1 are the extraction groups, 2-3 the injection groups */
+#define FDMA_INJ_PER        (2 + FDMA_INJ_GRP)
+
+#define FDMA_XTR_SOF_EOF (VTSS_F_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB_XTR_STAT_SOF | \
+                          VTSS_F_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB_XTR_STAT_EOF)
+
+/*****************************************************************************
+ *
+ *
+ * Prototypes for local functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+static void   fdma_enable (ulong ch_mask);
+static void   fdma_ch_start (const uchar ch, const uchar n, const ulong ctl0);
+static bool   fdma_ch_running (const uchar ch);
+static void   fdma_ch_stop (const uchar ch);
+static ushort fdma_onchip_addr (const uchar xdata * ptr);
+static void   fdma_memacc (ulong sba_addr, const uchar xdata * ptr, ushort len, const ulong examine);
+static ulong  fdma_swap (ulong val);
+#if USE_FDMA_XTR
+static bool   fdma_xtr_ready (const uchar grp);
+static void   fdma_xtr_next (const uchar grp);
+static void   fdma_xtr_stop (void);
+#endif
+#if USE_FDMA_INJ
+static void   fdma_inj_reclaim (void);
+static void   fdma_inj_start (void);
+static void   fdma_inj_stop (void);
+#endif
+
+/*****************************************************************************
+ *
+ *
+ * Local data
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Set by h2_fdma_interrupt() */
+static volatile uchar fdma_ch_pending;  /* Channels with completed blocks */
+static volatile uchar fdma_ch_err;      /* Channels that reported an error */
+
+#if USE_FDMA_XTR
+static bit            fdma_xtr_ena;
+static uchar xdata    fdma_xtr_head [VTSS_PACKET_RX_GROUP_CNT];
+static uchar xdata    fdma_xtr_tail [VTSS_PACKET_RX_GROUP_CNT];
+#endif
+
+#if USE_FDMA_INJ
+static bit            fdma_inj_ena;
+static uchar xdata    fdma_inj_head;    /* Oldest DCB in flight */
+static uchar xdata    fdma_inj_cnt;     /* DCBs in flight */
+static ushort xdata   fdma_inj_seq;     /* Ticket of the last frame queued */
+static ushort xdata   fdma_inj_done_seq;/* Ticket of the last frame sent */
+#endif
+
+#if USE_FDMA_XTR
+/* ************************************************************************ */
+void h2_fdma_xtr_init (uchar xdata * rx_buf, const ushort len)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Hand the extraction groups over to the FDMA.
+ * Remarks     : Frames are loaded from SBA RAM into rx_buf by MEMACC, so
+ *               rx_buf must be 32-bit aligned and mapped to on-chip memory.
+ *               Otherwise the groups are left to the register based path.
+ * Restrictions: Call after h2_rx_grp_conf(). RAM at FDMA_RAM_BASE must work.
+ * See also    : h2_fdma_xtr_active()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar grp, i;
+    ulong dcb;
+
+    fdma_xtr_ena = FALSE;
+
+    if(((ushort) rx_buf & 3) || fdma_onchip_addr(rx_buf) == 0xffff ||
+       fdma_onchip_addr(rx_buf + len - 1) - fdma_onchip_addr(rx_buf) != len - 1) {
+        return;
+    }
+
+    for(grp = VTSS_PACKET_RX_GROUP_START; grp < VTSS_PACKET_RX_GROUP_END; grp++) {
+        for(i = 0; i < FDMA_XTR_DCB_CNT; i++) {
+            dcb = FDMA_DCB_ADDR(FDMA_XTR_DCB(grp, i));
+            H2_WRITE(dcb + FDMA_DCB_SAR,   0);
+            H2_WRITE(dcb + FDMA_DCB_DAR,   FDMA_BUF_ADDR(FDMA_XTR_DCB(grp, i)));
+            H2_WRITE(dcb + FDMA_DCB_LLP,   (i + 1 < FDMA_XTR_DCB_CNT) ?
+                                           FDMA_DCB_ADDR(FDMA_XTR_DCB(grp, i + 1)) : 0);
+            H2_WRITE(dcb + FDMA_DCB_CTL0,  FDMA_XTR_CTL0);
+            H2_WRITE(dcb + FDMA_DCB_CTL1,  FDMA_XTR_CTL1);
+            H2_WRITE(dcb + FDMA_DCB_SSTAT, 0);
+        }
+        fdma_xtr_head[grp] = 0;
+        fdma_xtr_tail[grp] = FDMA_XTR_DCB_CNT - 1;
+
+        H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_XTR_CFG(grp),
+                 VTSS_F_ICPU_CFG_GPDMA_FDMA_XTR_CFG_XTR_BURST_SIZE(3));
+        H2_WRITE(VTSS_FDMA_CH_CFG0(FDMA_XTR_CH(grp)), 0);
+        H2_WRITE(VTSS_FDMA_CH_CFG1(FDMA_XTR_CH(grp)),
+                 VTSS_F_FDMA_CH_CFG1_SRC_PER(grp) | VTSS_F_FDMA_CH_CFG1_SS_UPD_EN);
+        /* Frame status is written back to DCB.SSTAT */
+        H2_WRITE(VTSS_FDMA_CH_SSTATAR(FDMA_XTR_CH(grp)),
+                 VTSS_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB(grp));
+        H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_CH_CFG(FDMA_XTR_CH(grp)),
+                 VTSS_F_ICPU_CFG_GPDMA_FDMA_CH_CFG_CH_ENA);
+
+        /* Let frame bytes reach RAM in wire order, as MEMACC copies by address */
+        H2_WRITE_MASKED(VTSS_DEVCPU_QS_XTR_XTR_GRP_CFG(grp),
+                        VTSS_F_DEVCPU_QS_XTR_XTR_GRP_CFG_BYTE_SWAP,
+                        VTSS_F_DEVCPU_QS_XTR_XTR_GRP_CFG_BYTE_SWAP);
+    }
+
+    fdma_enable(FDMA_XTR_CH_MASK);
+    for(grp = VTSS_PACKET_RX_GROUP_START; grp < VTSS_PACKET_RX_GROUP_END; grp++) {
+        fdma_ch_start(FDMA_XTR_CH(grp), FDMA_XTR_DCB(grp, 0), FDMA_XTR_CTL0);
+    }
+
+    fdma_xtr_ena = TRUE;
+}
+
+/* ************************************************************************ */
+bool h2_fdma_xtr_active (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Tell whether frames are extracted by the FDMA.
+ * Remarks     : A DMA error hands the groups back to the register based
+ *               path for good. Frames still in the ring are lost.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if(fdma_xtr_ena && (fdma_ch_err & FDMA_XTR_CH_MASK)) {
+        fdma_xtr_stop();
+    }
+    return fdma_xtr_ena;
+}
+
+/* ************************************************************************ */
+uchar h2_fdma_xtr_get (const uchar grp, vtss_rx_frame_t xdata * rx_frame_ptr)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the oldest frame in the ring of a group.
+ * Remarks     : On FDMA_XTR_FRAME the header, total_bytes, pruned and the
+ *               first 16 bytes of rx_packet are filled in, which is enough
+ *               to classify the frame. The frame must then be finished with
+ *               h2_fdma_xtr_done().
+ * Restrictions: Only while h2_fdma_xtr_active() is TRUE.
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    uchar  n = FDMA_XTR_DCB(grp, fdma_xtr_head[grp]);
+    ulong  val, ifh0, ifh1;
+    ushort len;
+
+    if(!fdma_xtr_ready(grp)) {
+        return FDMA_XTR_EMPTY;
+    }
+
+    H2_READ(FDMA_DCB_ADDR(n) + FDMA_DCB_SSTAT, val);
+    len = VTSS_X_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB_XTR_STAT_FRM_LEN(val);
+    if((val & (FDMA_XTR_SOF_EOF | VTSS_F_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB_XTR_STAT_ABORT)) != FDMA_XTR_SOF_EOF ||
+       len < 8 + 16 || len - 8 > FDMA_XTR_MAX_LENGTH) {
+        /* Aborted, or a jumbo frame spanning more than one DCB */
+        fdma_xtr_next(grp);
+        return FDMA_XTR_ERROR;
+    }
+
+    H2_READ(FDMA_BUF_ADDR(n), ifh0);
+    H2_READ(FDMA_BUF_ADDR(n) + 4, ifh1);
+    ifh0 = fdma_swap(ifh0);
+    ifh1 = fdma_swap(ifh1);
+
+    memset(&rx_frame_ptr->header, 0, sizeof(vtss_packet_rx_header_t));
+    rx_frame_ptr->header.port = IFH_GET(ifh0, ifh1, PORT);
+    rx_frame_ptr->header.vid  = IFH_GET(ifh0, ifh1, VID);
+    rx_frame_ptr->header.cpuq = IFH_GET(ifh0, ifh1, CPUQ);
+    rx_frame_ptr->total_bytes = len - 8;
+    rx_frame_ptr->pruned = (val & VTSS_F_ICPU_CFG_GPDMA_FDMA_XTR_STAT_LAST_DCB_XTR_STAT_PRUNED) ? 1 : 0;
+
+    fdma_memacc(FDMA_BUF_ADDR(n) + 8, rx_frame_ptr->rx_packet, 16, 0);
+
+    return FDMA_XTR_FRAME;
+}
+
+/* ************************************************************************ */
+void h2_fdma_xtr_done (const uchar grp, vtss_rx_frame_t xdata * rx_frame_ptr)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Finish the frame returned by h2_fdma_xtr_get().
+ * Remarks     : Unless the frame is marked as discarded the rest of it is
+ *               loaded into rx_packet. Its buffer is then given back to the
+ *               FDMA.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if(!rx_frame_ptr->discard && rx_frame_ptr->total_bytes > 16) {
+        fdma_memacc(FDMA_BUF_ADDR(FDMA_XTR_DCB(grp, fdma_xtr_head[grp])) + 8 + 16,
+                    rx_frame_ptr->rx_packet + 16,
+                    rx_frame_ptr->total_bytes - 16, 0);
+    }
+    fdma_xtr_next(grp);
+}
+
+#if LOOPBACK_TEST
+/* ************************************************************************ */
+bool h2_fdma_xtr_skip (const uchar grp)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Drop the oldest frame in the ring of a group unseen.
+ * Remarks     : Returns FALSE if the ring is empty.
+ * Restrictions: Only while h2_fdma_xtr_active() is TRUE.
+ * See also    : h2_rx_frame_drop()
+ * Example     :
+ ****************************************************************************/
+{
+    if(!fdma_xtr_ready(grp)) {
+        return FALSE;
+    }
+    fdma_xtr_next(grp);
+    return TRUE;
+}
+#endif /* LOOPBACK_TEST */
+#endif /* USE_FDMA_XTR */
+
+#if USE_FDMA_INJ
+/* ************************************************************************ */
+void h2_fdma_inj_init (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Hand injection group FDMA_INJ_GRP over to the FDMA.
+ * Remarks     : The other injection group stays register based.
+ * Restrictions: RAM at FDMA_RAM_BASE must work.
+ * See also    : h2_fdma_inj_frame()
+ * Example     :
+ ****************************************************************************/
+{
+    fdma_inj_head = 0;
+    fdma_inj_cnt = 0;
+    fdma_inj_seq = 0;
+    fdma_inj_done_seq = 0;
+
+    H2_WRITE(VTSS_FDMA_CH_CFG0(FDMA_INJ_CH), 0);
+    H2_WRITE(VTSS_FDMA_CH_CFG1(FDMA_INJ_CH), VTSS_F_FDMA_CH_CFG1_DST_PER(FDMA_INJ_PER));
+    H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_INJ_CFG(FDMA_INJ_GRP),
+             VTSS_F_ICPU_CFG_GPDMA_FDMA_INJ_CFG_INJ_GRP_BP_ENA |
+             VTSS_F_ICPU_CFG_GPDMA_FDMA_INJ_CFG_INJ_GRP_BP_MAP(FDMA_INJ_CH));
+    H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_CH_CFG(FDMA_INJ_CH),
+             VTSS_F_ICPU_CFG_GPDMA_FDMA_CH_CFG_USAGE |
+             VTSS_F_ICPU_CFG_GPDMA_FDMA_CH_CFG_CH_ENA);
+
+    /* Frame bytes are in RAM in wire order */
+    H2_WRITE_MASKED(VTSS_DEVCPU_QS_INJ_INJ_GRP_CFG(FDMA_INJ_GRP),
+                    VTSS_F_DEVCPU_QS_INJ_INJ_GRP_CFG_BYTE_SWAP,
+                    VTSS_F_DEVCPU_QS_INJ_INJ_GRP_CFG_BYTE_SWAP);
+
+    fdma_enable(FDMA_INJ_CH_MASK);
+
+    fdma_inj_ena = TRUE;
+}
+
+/* ************************************************************************ */
+bool h2_fdma_inj_active (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Tell whether FDMA_INJ_GRP is used by the FDMA.
+ * Remarks     : A DMA error hands the group back to the register based
+ *               path for good. Frames in flight are reported as sent.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if(fdma_inj_ena && (fdma_ch_err & FDMA_INJ_CH_MASK)) {
+        fdma_inj_stop();
+    }
+    return fdma_inj_ena;
+}
+
+/* ************************************************************************ */
+bool h2_fdma_inj_usable (const uchar xdata * frame, const ushort length)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Tell whether a frame can be sent with h2_fdma_inj_frame().
+ * Remarks     : The frame is copied to SBA RAM by MEMACC, so it must be
+ *               32-bit aligned and mapped to on-chip memory.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    return h2_fdma_inj_active() && !((ushort) frame & 3) && length > 12 &&
+           length + 8 + 4 + 4 + 3 <= FDMA_BUF_SIZE &&
+           fdma_onchip_addr(frame) != 0xffff &&
+           fdma_onchip_addr(frame + length - 1) - fdma_onchip_addr(frame) == length - 1;
+}
+
+/* ************************************************************************ */
+ushort h2_fdma_inj_frame (const uchar port_no,
+                          const uchar xdata * frame,
+                          const ushort length,
+                          const vtss_vid_t vid)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Queue a frame for transmission on the specified port.
+ * Remarks     : The frame is copied and the call returns at once, the
+ *               buffer may be reused right away. Returns a ticket for
+ *               h2_fdma_inj_done(), or 0 if all DCBs are in flight.
+ *               A C-tag is inserted unless vid is VTSS_VID_NULL. Frames are
+ *               padded to 60 bytes and to a whole number of 32-bit words.
+ * Restrictions: Only if h2_fdma_inj_usable() returns TRUE.
+ * See also    : h2_tx_frame_port()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar  n;
+    ulong  buf, dcb;
+    ushort w;
+
+    h2_fdma_inj_poll();
+    if(fdma_inj_cnt == FDMA_INJ_DCB_CNT) {
+        return 0;
+    }
+
+    n   = FDMA_INJ_DCB((fdma_inj_head + fdma_inj_cnt) % FDMA_INJ_DCB_CNT);
+    buf = FDMA_BUF_ADDR(n);
+    dcb = FDMA_DCB_ADDR(n);
+
+    /* IFH: BYPASS, DEST and POP_CNT=3 to disable the rewriter */
+    H2_WRITE(buf,     fdma_swap(VTSS_ENCODE_BITFIELD(1, 63 - 32, 1) |
+                                VTSS_ENCODE_BITFIELD(1, port_no, 1)));
+    H2_WRITE(buf + 4, fdma_swap(VTSS_ENCODE_BITFIELD(3, 28, 2)));
+
+    if(vid != VTSS_VID_NULL) {
+        fdma_memacc(buf + 8, frame, 12, VTSS_F_ICPU_CFG_MPU8051_MEMACC_CTRL_MEMACC_EXAMINE);
+        H2_WRITE(buf + 8 + 12, fdma_swap(ushorts2ulong(0x8100, vid)));
+        fdma_memacc(buf + 8 + 16, frame + 12, length - 12,
+                    VTSS_F_ICPU_CFG_MPU8051_MEMACC_CTRL_MEMACC_EXAMINE);
+        w = (length + 4 + 3) / 4;
+    } else {
+        fdma_memacc(buf + 8, frame, length, VTSS_F_ICPU_CFG_MPU8051_MEMACC_CTRL_MEMACC_EXAMINE);
+        w = (length + 3) / 4;
+    }
+
+    /* Add padding and a dummy CRC */
+    while(w < 15 /*(60/4)*/ ) {
+        H2_WRITE(buf + 8 + 4 * w, 0);
+        w++;
+    }
+    H2_WRITE(buf + 8 + 4 * w, 0);
+    w += 1 + 2;
+
+    H2_WRITE(dcb + FDMA_DCB_SAR,  buf);
+    H2_WRITE(dcb + FDMA_DCB_DAR,  0);
+    H2_WRITE(dcb + FDMA_DCB_LLP,  0);
+    H2_WRITE(dcb + FDMA_DCB_CTL0, FDMA_INJ_CTL0);
+    H2_WRITE(dcb + FDMA_DCB_CTL1, VTSS_F_FDMA_CH_CTL1_BLOCK_TS(w));
+
+    if(fdma_inj_cnt) {
+        /* Append to the DCB queued last */
+        H2_WRITE(FDMA_DCB_ADDR(FDMA_INJ_DCB((fdma_inj_head + fdma_inj_cnt - 1) % FDMA_INJ_DCB_CNT)) +
+                 FDMA_DCB_LLP, dcb);
+    }
+    fdma_inj_cnt++;
+    fdma_inj_start();
+
+    return ++fdma_inj_seq ? fdma_inj_seq : ++fdma_inj_seq;
+}
+
+/* ************************************************************************ */
+bool h2_fdma_inj_done (const ushort ticket)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Tell whether a frame queued by h2_fdma_inj_frame() has been
+ *               handed to the injection group.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    h2_fdma_inj_poll();
+    return (short) (fdma_inj_done_seq - ticket) >= 0;
+}
+
+/* ************************************************************************ */
+void h2_fdma_inj_poll (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Reclaim the DCBs of sent frames.
+ * Remarks     : Cheap unless h2_fdma_interrupt() has seen the channel
+ *               complete a block or stop.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if(!h2_fdma_inj_active() || !(fdma_ch_pending & FDMA_INJ_CH_MASK)) {
+        return;
+    }
+    EA = 0;
+    fdma_ch_pending &= ~FDMA_INJ_CH_MASK;
+    EA = 1;
+
+    fdma_inj_reclaim();
+    fdma_inj_start();
+}
+#endif /* USE_FDMA_INJ */
+
+#pragma NOAREGS
+/* ************************************************************************ */
+void h2_fdma_interrupt (void) small
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Note which channels have completed DCBs, stopped or failed.
+ * Remarks     : Called from ext_0_interrupt(), the rings themselves are
+ *               handled from the main loop.
+ * Restrictions: ISR could only call H2_READ, H2_WRITE, H2_WRITE_MASKED
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ulong status;
+
+    H2_READ(VTSS_FDMA_INTR_STATUS_BLOCK, status);
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_BLOCK, status);
+    fdma_ch_pending |= (uchar) VTSS_X_FDMA_INTR_STATUS_BLOCK_STATUS_BLOCK(status);
+
+    H2_READ(VTSS_FDMA_INTR_STATUS_TFR, status);
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_TFR, status);
+    fdma_ch_pending |= (uchar) VTSS_X_FDMA_INTR_STATUS_TFR_STATUS_TFR(status);
+
+    H2_READ(VTSS_FDMA_INTR_STATUS_ERR, status);
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_ERR, status);
+    fdma_ch_err |= (uchar) VTSS_X_FDMA_INTR_STATUS_ERR_STATUS_ERR(status);
+}
+#pragma AREGS
+
+/*****************************************************************************
+ *
+ *
+ * Local functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+static void fdma_enable (ulong ch_mask)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Enable the FDMA and its interrupts for some channels.
+ * Remarks     : Safe to call once per user of the FDMA.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_CFG, VTSS_F_ICPU_CFG_GPDMA_FDMA_CFG_FDMA_ENA);
+    H2_WRITE(VTSS_FDMA_MISC_DMA_CFG_REG, VTSS_F_FDMA_MISC_DMA_CFG_REG_DMA_EN);
+
+    EA = 0;
+    fdma_ch_pending |= (uchar) ch_mask;
+    fdma_ch_err     &= (uchar) ~ch_mask;
+    EA = 1;
+
+    /* Interrupt on completed DCBs, stopped channels and errors */
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_BLOCK, VTSS_F_FDMA_INTR_CLEAR_BLOCK_CLEAR_BLOCK(ch_mask));
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_TFR,   VTSS_F_FDMA_INTR_CLEAR_TFR_CLEAR_TFR(ch_mask));
+    H2_WRITE(VTSS_FDMA_INTR_CLEAR_ERR,   VTSS_F_FDMA_INTR_CLEAR_ERR_CLEAR_ERR(ch_mask));
+    H2_WRITE(VTSS_FDMA_INTR_MASK_BLOCK,
+             VTSS_F_FDMA_INTR_MASK_BLOCK_INT_MASK_WE_BLOCK(ch_mask) |
+             VTSS_F_FDMA_INTR_MASK_BLOCK_INT_MASK_BLOCK(ch_mask));
+    H2_WRITE(VTSS_FDMA_INTR_MASK_TFR,
+             VTSS_F_FDMA_INTR_MASK_TFR_INT_MASK_WE_TFR(ch_mask) |
+             VTSS_F_FDMA_INTR_MASK_TFR_INT_MASK_TFR(ch_mask));
+    H2_WRITE(VTSS_FDMA_INTR_MASK_ERR,
+             VTSS_F_FDMA_INTR_MASK_ERR_INT_MASK_WE_ERR(ch_mask) |
+             VTSS_F_FDMA_INTR_MASK_ERR_INT_MASK_ERR(ch_mask));
+
+    H2_WRITE_MASKED(VTSS_ICPU_CFG_INTR_FDMA_INTR_CFG,
+                    VTSS_F_ICPU_CFG_INTR_FDMA_INTR_CFG_FDMA_INTR_SEL(0),
+                    VTSS_M_ICPU_CFG_INTR_FDMA_INTR_CFG_FDMA_INTR_SEL);
+    H2_WRITE_MASKED(VTSS_ICPU_CFG_INTR_INTR_ENA,
+                    VTSS_F_ICPU_CFG_INTR_INTR_ENA_FDMA_INTR_ENA,
+                    VTSS_F_ICPU_CFG_INTR_INTR_ENA_FDMA_INTR_ENA);
+}
+
+static void fdma_ch_start (const uchar ch, const uchar n, const ulong ctl0)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Start a channel at DCB number n.
+ * Remarks     :
+ * Restrictions: The channel must be stopped.
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    H2_WRITE(VTSS_FDMA_CH_LLP(ch), FDMA_DCB_ADDR(n));
+    H2_WRITE(VTSS_FDMA_CH_CTL0(ch), ctl0);
+    H2_WRITE(VTSS_FDMA_MISC_CH_EN_REG,
+             VTSS_F_FDMA_MISC_CH_EN_REG_CH_EN_WE(VTSS_BIT(ch)) |
+             VTSS_F_FDMA_MISC_CH_EN_REG_CH_EN(VTSS_BIT(ch)));
+}
+
+static bool fdma_ch_running (const uchar ch)
+{
+    ulong ch_en;
+
+    H2_READ(VTSS_FDMA_MISC_CH_EN_REG, ch_en);
+    return (VTSS_X_FDMA_MISC_CH_EN_REG_CH_EN(ch_en) & VTSS_BIT(ch)) ? TRUE : FALSE;
+}
+
+static void fdma_ch_stop (const uchar ch)
+{
+    H2_WRITE(VTSS_FDMA_INTR_MASK_BLOCK, VTSS_F_FDMA_INTR_MASK_BLOCK_INT_MASK_WE_BLOCK(VTSS_BIT(ch)));
+    H2_WRITE(VTSS_FDMA_INTR_MASK_TFR,   VTSS_F_FDMA_INTR_MASK_TFR_INT_MASK_WE_TFR(VTSS_BIT(ch)));
+    H2_WRITE(VTSS_FDMA_INTR_MASK_ERR,   VTSS_F_FDMA_INTR_MASK_ERR_INT_MASK_WE_ERR(VTSS_BIT(ch)));
+    H2_WRITE(VTSS_FDMA_MISC_CH_EN_REG, VTSS_F_FDMA_MISC_CH_EN_REG_CH_EN_WE(VTSS_BIT(ch)));
+    H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_CH_CFG(ch), 0);
+}
+
+static ushort fdma_onchip_addr (const uchar xdata * ptr)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Translate an xdata address to an on-chip memory address.
+ * Remarks     : Returns 0xffff if the address is not mapped on-chip.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ushort addr = (ushort) ptr;
+    uchar  mmap = MMAP;
+
+    if(addr & 0x8000) {
+        if(!(mmap & VTSS_F_ICPU_CFG_MPU8051_MPU8051_MMAP_MAP_DATA_HIGH)) {
+            return 0xffff;
+        }
+        addr &= 0x7fff;
+        if(mmap & VTSS_F_ICPU_CFG_MPU8051_MPU8051_MMAP_MSADDR_DATA_HIGH) {
+            addr |= 0x8000;
+        }
+    } else {
+        if(!(mmap & VTSS_F_ICPU_CFG_MPU8051_MPU8051_MMAP_MAP_DATA_LOW)) {
+            return 0xffff;
+        }
+        if(mmap & VTSS_F_ICPU_CFG_MPU8051_MPU8051_MMAP_MSADDR_DATA_LOW) {
+            addr |= 0x8000;
+        }
+    }
+    return addr;
+}
+
+static void fdma_memacc (ulong sba_addr, const uchar xdata * ptr, ushort len, const ulong examine)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Copy len bytes between SBA RAM and ptr in whole 32-bit words.
+ * Remarks     : examine 0 loads ptr from RAM, MEMACC_EXAMINE stores ptr to
+ *               RAM. ptr must be aligned, up to 3 bytes beyond len are moved.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ushort start = fdma_onchip_addr(ptr);
+    ulong  ctrl;
+
+    H2_WRITE(VTSS_ICPU_CFG_MPU8051_MEMACC_SBA,
+             VTSS_F_ICPU_CFG_MPU8051_MEMACC_SBA_MEMACC_SBA_START(sba_addr >> 2));
+    H2_WRITE(VTSS_ICPU_CFG_MPU8051_MEMACC,
+             VTSS_F_ICPU_CFG_MPU8051_MEMACC_MEMACC_STOP((start + len - 1) >> 2) |
+             VTSS_F_ICPU_CFG_MPU8051_MEMACC_MEMACC_START(start >> 2));
+    H2_WRITE(VTSS_ICPU_CFG_MPU8051_MEMACC_CTRL, examine | VTSS_F_ICPU_CFG_MPU8051_MEMACC_CTRL_MEMACC_DO);
+    do {
+        H2_READ(VTSS_ICPU_CFG_MPU8051_MEMACC_CTRL, ctrl);
+    } while(ctrl & VTSS_F_ICPU_CFG_MPU8051_MEMACC_CTRL_MEMACC_DO);
+}
+
+static ulong fdma_swap (ulong val)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Convert between a register value and a little-endian word
+ *               in RAM, e.g. for the IFH.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    return (val << 24) | ((val << 8) & 0x00ff0000UL) |
+           ((val >> 8) & 0x0000ff00UL) | (val >> 24);
+}
+
+#if USE_FDMA_XTR
+static bool fdma_xtr_ready (const uchar grp)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Tell whether the head DCB of a group holds a frame.
+ * Remarks     : Restarts the channel if it ran off the tail of a drained
+ *               ring.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    uchar ch_mask = 1 << FDMA_XTR_CH(grp);
+    uchar n = FDMA_XTR_DCB(grp, fdma_xtr_head[grp]);
+    ulong val;
+
+    if(!(fdma_ch_pending & ch_mask)) {
+        return FALSE;
+    }
+    EA = 0;
+    fdma_ch_pending &= ~ch_mask;
+    EA = 1;
+
+    H2_READ(FDMA_DCB_ADDR(n) + FDMA_DCB_CTL1, val);
+    if(!(val & VTSS_F_FDMA_CH_CTL1_DONE)) {
+        if(!fdma_ch_running(FDMA_XTR_CH(grp))) {
+            fdma_ch_start(FDMA_XTR_CH(grp), n, FDMA_XTR_CTL0);
+        }
+        return FALSE;
+    }
+
+    /* Look for the next one on the following call as well */
+    EA = 0;
+    fdma_ch_pending |= ch_mask;
+    EA = 1;
+    return TRUE;
+}
+
+static void fdma_xtr_next (const uchar grp)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Move the head DCB of a group to the tail of its ring.
+ * Remarks     : If the channel already fetched the old tail it stops there,
+ *               and is restarted by h2_fdma_xtr_get() when the ring is empty.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    uchar i = fdma_xtr_head[grp];
+    ulong dcb = FDMA_DCB_ADDR(FDMA_XTR_DCB(grp, i));
+
+    H2_WRITE(dcb + FDMA_DCB_LLP, 0);
+    H2_WRITE(dcb + FDMA_DCB_CTL1, FDMA_XTR_CTL1);
+    H2_WRITE(FDMA_DCB_ADDR(FDMA_XTR_DCB(grp, fdma_xtr_tail[grp])) + FDMA_DCB_LLP, dcb);
+
+    fdma_xtr_tail[grp] = i;
+    fdma_xtr_head[grp] = (i + 1) % FDMA_XTR_DCB_CNT;
+}
+
+static void fdma_xtr_stop (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Give the extraction groups back to the register based path.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    uchar grp;
+
+    for(grp = VTSS_PACKET_RX_GROUP_START; grp < VTSS_PACKET_RX_GROUP_END; grp++) {
+        fdma_ch_stop(FDMA_XTR_CH(grp));
+        H2_WRITE_MASKED(VTSS_DEVCPU_QS_XTR_XTR_GRP_CFG(grp), 0,
+                        VTSS_F_DEVCPU_QS_XTR_XTR_GRP_CFG_BYTE_SWAP);
+    }
+
+    fdma_xtr_ena = FALSE;
+}
+#endif /* USE_FDMA_XTR */
+
+#if USE_FDMA_INJ
+static void fdma_inj_reclaim (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Release the DCBs at the head of the queue that are done.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ulong ctl1;
+
+    while(fdma_inj_cnt) {
+        H2_READ(FDMA_DCB_ADDR(FDMA_INJ_DCB(fdma_inj_head)) + FDMA_DCB_CTL1, ctl1);
+        if(!(ctl1 & VTSS_F_FDMA_CH_CTL1_DONE)) {
+            break;
+        }
+        fdma_inj_head = (fdma_inj_head + 1) % FDMA_INJ_DCB_CNT;
+        fdma_inj_cnt--;
+        fdma_inj_done_seq++;
+        if(!fdma_inj_done_seq) {
+            fdma_inj_done_seq++;    /* Ticket 0 is never handed out */
+        }
+    }
+}
+
+static void fdma_inj_start (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Start the channel at the oldest DCB not sent yet.
+ * Remarks     : Does nothing while the channel is running. If it fetched
+ *               the last DCB before a new one was appended, the TFR
+ *               interrupt brings us back here through h2_fdma_inj_poll().
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if(fdma_ch_running(FDMA_INJ_CH)) {
+        return;
+    }
+    /* Stopped, so nothing completes behind our back */
+    fdma_inj_reclaim();
+    if(fdma_inj_cnt) {
+        fdma_ch_start(FDMA_INJ_CH, FDMA_INJ_DCB(fdma_inj_head), FDMA_INJ_CTL0);
+    }
+}
+
+static void fdma_inj_stop (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Give FDMA_INJ_GRP back to the register based path.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    fdma_ch_stop(FDMA_INJ_CH);
+    H2_WRITE(VTSS_ICPU_CFG_GPDMA_FDMA_INJ_CFG(FDMA_INJ_GRP), 0);
+    H2_WRITE_MASKED(VTSS_DEVCPU_QS_INJ_INJ_GRP_CFG(FDMA_INJ_GRP), 0,
+                    VTSS_F_DEVCPU_QS_INJ_INJ_GRP_CFG_BYTE_SWAP);
+
+    fdma_inj_cnt = 0;
+    fdma_inj_done_seq = fdma_inj_seq;
+    fdma_inj_ena = FALSE;
+}
+#endif /* USE_FDMA_INJ */
+
+#endif /* USE_FDMA_XTR || USE_FDMA_INJ */
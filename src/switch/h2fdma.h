@@ -0,0 +1,47 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+#ifndef __H2FDMA_H__
+#define __H2FDMA_H__
+
+#include "h2packet.h"
+
+#if USE_FDMA_XTR
+
+/* Return values of h2_fdma_xtr_get() */
+#define FDMA_XTR_EMPTY  0   /* No frame in the ring */
+#define FDMA_XTR_FRAME  1   /* Frame found, IFH and first 16 bytes loaded */
+#define FDMA_XTR_ERROR  2   /* Aborted, partial or too long frame dropped */
+
+void   h2_fdma_xtr_init (uchar xdata * rx_buf, const ushort len);
+bool   h2_fdma_xtr_active (void);
+uchar  h2_fdma_xtr_get (const uchar grp, vtss_rx_frame_t xdata * rx_frame_ptr);
+void   h2_fdma_xtr_done (const uchar grp, vtss_rx_frame_t xdata * rx_frame_ptr);
+#if LOOPBACK_TEST
+bool   h2_fdma_xtr_skip (const uchar grp);
+#endif
+
+#endif /* USE_FDMA_XTR */
+
+#if USE_FDMA_INJ
+
+/* Injection group used by the FDMA, the other one stays register based */
+#define FDMA_INJ_GRP    (VTSS_PACKET_TX_QUEUE_END - 1)
+
+void   h2_fdma_inj_init (void);
+bool   h2_fdma_inj_active (void);
+bool   h2_fdma_inj_usable (const uchar xdata * frame, const ushort length);
+ushort h2_fdma_inj_frame (const uchar port_no,
+                          const uchar xdata * frame,
+                          const ushort length,
+                          const vtss_vid_t vid);
+bool   h2_fdma_inj_done (const ushort ticket);
+void   h2_fdma_inj_poll (void);
+
+#endif /* USE_FDMA_INJ */
+
+#if USE_FDMA_XTR || USE_FDMA_INJ
+void   h2_fdma_interrupt (void) small;
+#endif
+
+#endif
@@ -0,0 +1,554 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+
+#include "common.h"     /* Always include common.h at the first place of user-defined herder files */
+
+#if TRANSIT_IGMP_SNOOP
+
+#include "vtss_luton26_reg.h"
+#include "h2io.h"
+#include "h2packet.h"
+#include "h2txrxaux.h"
+#include "h2mactab.h"
+#include "h2igmp.h"
+#include "phytsk.h"
+#include "misc2.h"
+#include <string.h>
+
+/*****************************************************************************
+ *
+ *
+ * Defines
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Timers count down in ticks of IGMP_TICK_SEC seconds. A timer set for sec
+   seconds never expires earlier, whatever the phase of the tick. */
+#define IGMP_TICK_SEC           2
+#define IGMP_TICKS(sec)         ((sec) ? ((sec) + 2 * IGMP_TICK_SEC - 1) / IGMP_TICK_SEC : 0)
+
+#if IGMP_TICKS(IGMP_MEMBER_TIMEOUT) > 255 || IGMP_TICKS(IGMP_ROUTER_TIMEOUT) > 255
+#error "IGMP_MEMBER_TIMEOUT and IGMP_ROUTER_TIMEOUT must be below 510 sec"
+#endif
+
+#if IGMP_GROUP_MAX > 32
+#error "IGMP_GROUP_MAX must be at most 32"
+#endif
+
+/* PGIDs used. Group n forwards to PGID IGMP_PGID_START + n, unregistered
+   IPv4 multicast data to IGMP_PGID_UNREG (router ports) or IGMP_PGID_FLOOD
+   (all ports, the reset value of ANA:ANA:FLOODING_IPMC). */
+#define IGMP_PGID_START         30
+#define IGMP_PGID_UNREG         62
+#define IGMP_PGID_FLOOD         63
+
+#define IP_PROTO_IGMP           2
+
+/* IGMP message types */
+#define IGMP_TYPE_QUERY         0x11
+#define IGMP_TYPE_V1_REPORT     0x12
+#define IGMP_TYPE_V2_REPORT     0x16
+#define IGMP_TYPE_LEAVE         0x17
+#define IGMP_TYPE_V3_REPORT     0x22
+
+/* IGMPv3 group record types, RFC 3376 */
+#define IGMP_REC_IS_IN          1
+#define IGMP_REC_IS_EX          2
+#define IGMP_REC_TO_IN          3
+#define IGMP_REC_TO_EX          4
+#define IGMP_REC_ALLOW          5
+#define IGMP_REC_BLOCK          6
+
+/*****************************************************************************
+ *
+ *
+ * Typedefs and enums
+ *
+ *
+ *
+ ****************************************************************************/
+
+typedef struct {
+    ulong  group;               /* Group address, 0 if the entry is free */
+    ushort vid;
+    uchar  timer [MAX_PORT];    /* Ticks left for the listeners of a port */
+} igmp_group_t;
+
+/*****************************************************************************
+ *
+ *
+ * Prototypes for local functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+static void            igmp_join (ulong group, ushort vid, uchar port_no);
+static void            igmp_leave (ulong group, ushort vid, uchar port_no);
+static uchar           igmp_group_find (ulong group, ushort vid);
+static port_bit_mask_t igmp_group_members (uchar idx);
+static void            igmp_group_commit (uchar idx);
+static void            igmp_router_commit (void);
+static void            igmp_flood_commit (void);
+static void            igmp_forward (vtss_rx_frame_t xdata *frame, ushort length,
+                                     port_bit_mask_t mask);
+static bool            igmp_csum_ok (const uchar xdata *igmp, ushort length);
+
+/*****************************************************************************
+ *
+ *
+ * Local data
+ *
+ *
+ *
+ ****************************************************************************/
+
+static igmp_group_t    xdata igmp_groups [IGMP_GROUP_MAX];
+static uchar           xdata igmp_router_timer [MAX_PORT];
+static port_bit_mask_t xdata igmp_router_mask;
+static ulong           xdata igmp_cnt [IGMP_CNT_CNT];
+static uchar           xdata igmp_tick;
+static uchar           xdata igmp_full_timer;   /* Ticks left flooding after a join found the table full */
+
+/* ************************************************************************ */
+void h2_igmp_init (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Forget all groups and router ports and flood unregistered
+ *               IPv4 multicast to all ports.
+ * Remarks     : IGMP frames are redirected to the CPU by h2_rx_init().
+ * Restrictions: To be called after h2_mactab_clear().
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    memset(igmp_groups, 0, sizeof(igmp_groups));
+    memset(igmp_router_timer, 0, sizeof(igmp_router_timer));
+    memset(igmp_cnt, 0, sizeof(igmp_cnt));
+    igmp_router_mask = 0;
+    igmp_tick = 0;
+    igmp_full_timer = 0;
+    igmp_router_commit();
+}
+
+/* ************************************************************************ */
+void h2_igmp_frame_received (vtss_rx_frame_t xdata *frame)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Snoop an IPv4 frame redirected to the CPU and forward it.
+ * Remarks     : Queries make the ingress port a router port and are sent to
+ *               all other ports with link. Reports and leaves update the
+ *               group listeners and are sent to the router ports only, so
+ *               hosts do not suppress their own reports. Source lists of
+ *               IGMPv3 are not tracked, any source joins the group.
+ * Restrictions: The frame must be complete, i.e. not truncated.
+ * See also    : h2_igmp_1sec()
+ * Example     :
+ ****************************************************************************/
+{
+    const uchar xdata *ip;
+    const uchar xdata *igmp;
+    const uchar xdata *rec;
+    ushort length, ip_len, igmp_len, rec_cnt, src_cnt, rec_len;
+    uchar  port_no, hdr_len;
+    ushort vid;
+    ulong  group;
+
+    if (frame->total_bytes < FCS_SIZE_BYTES + 14 + 20 + 8 ||
+        frame->header.port >= MAX_PORT) {
+        igmp_cnt[IGMP_CNT_INVALID]++;
+        return;
+    }
+    length  = frame->total_bytes - FCS_SIZE_BYTES;
+    port_no = frame->header.port;
+    vid     = frame->header.vid;
+
+    /* Skip an optional C-tag */
+    ip = frame->rx_packet + 12;
+    if (*(ushort xdata *) ip == VTSS_ETHTYPE_CTAG) {
+        ip += 4;
+    }
+    if (*(ushort xdata *) ip != VTSS_ETHTYPE_IP) {
+        return;
+    }
+    ip += 2;
+
+    hdr_len = (ip[0] & 0x0f) * 4;
+    ip_len  = *(ushort xdata *) (ip + 2);
+    if ((ip[0] >> 4) != 4 || hdr_len < 20 || ip[9] != IP_PROTO_IGMP ||
+        ip_len < hdr_len + 8 || ip + ip_len > frame->rx_packet + length) {
+        igmp_cnt[IGMP_CNT_INVALID]++;
+        return;
+    }
+    igmp     = ip + hdr_len;
+    igmp_len = ip_len - hdr_len;
+    if (!igmp_csum_ok(igmp, igmp_len)) {
+        igmp_cnt[IGMP_CNT_INVALID]++;
+        return;
+    }
+    group = *(ulong xdata *) (igmp + 4);
+
+    switch (igmp[0]) {
+    case IGMP_TYPE_QUERY:
+        igmp_cnt[IGMP_CNT_QUERY]++;
+        /* Queries from a snooping switch without an address are no router */
+        if (*(ulong xdata *) (ip + 12) != 0) {
+            if (!igmp_router_timer[port_no]) {
+                WRITE_PORT_BIT_MASK(port_no, 1, &igmp_router_mask);
+                igmp_router_commit();
+            }
+            igmp_router_timer[port_no] = IGMP_TICKS(IGMP_ROUTER_TIMEOUT);
+        }
+        igmp_forward(frame, length, ALL_PORTS);
+        break;
+
+    case IGMP_TYPE_V1_REPORT:
+    case IGMP_TYPE_V2_REPORT:
+        igmp_cnt[IGMP_CNT_REPORT]++;
+        igmp_join(group, vid, port_no);
+        igmp_forward(frame, length, igmp_router_mask);
+        break;
+
+    case IGMP_TYPE_LEAVE:
+        igmp_cnt[IGMP_CNT_LEAVE]++;
+        igmp_leave(group, vid, port_no);
+        igmp_forward(frame, length, igmp_router_mask);
+        break;
+
+    case IGMP_TYPE_V3_REPORT:
+        igmp_cnt[IGMP_CNT_V3_REPORT]++;
+        rec_cnt = *(ushort xdata *) (igmp + 6);
+        rec = igmp + 8;
+        for (; rec_cnt; rec_cnt--, rec += rec_len) {
+            if (rec + 8 > igmp + igmp_len) {
+                igmp_cnt[IGMP_CNT_INVALID]++;
+                break;
+            }
+            src_cnt = *(ushort xdata *) (rec + 2);
+            rec_len = 8 + 4 * (src_cnt + rec[1]);
+            group   = *(ulong xdata *) (rec + 4);
+            switch (rec[0]) {
+            case IGMP_REC_IS_EX:
+            case IGMP_REC_TO_EX:
+                igmp_join(group, vid, port_no);
+                break;
+            case IGMP_REC_IS_IN:
+            case IGMP_REC_ALLOW:
+                if (src_cnt) {
+                    igmp_join(group, vid, port_no);
+                }
+                break;
+            case IGMP_REC_TO_IN:
+                if (src_cnt) {
+                    igmp_join(group, vid, port_no);
+                } else {
+                    igmp_leave(group, vid, port_no);
+                }
+                break;
+            }
+        }
+        igmp_forward(frame, length, igmp_router_mask);
+        break;
+
+    default:
+        /* E.g. DVMRP or PIMv1, forward as before */
+        igmp_forward(frame, length, ALL_PORTS);
+        break;
+    }
+}
+
+/* ************************************************************************ */
+void h2_igmp_1sec (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Age the listeners and router ports.
+ * Remarks     : Ports without link lose their listeners and router status
+ *               at the next tick.
+ * Restrictions: To be called every second.
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    port_bit_mask_t link_mask;
+    uchar           idx, port_no;
+    bool            changed;
+    igmp_group_t    xdata *grp;
+
+    if (++igmp_tick < IGMP_TICK_SEC) {
+        return;
+    }
+    igmp_tick = 0;
+    link_mask = phy_get_link_mask();
+
+    changed = FALSE;
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (igmp_router_timer[port_no] &&
+            (!TEST_PORT_BIT_MASK(port_no, &link_mask) ||
+             --igmp_router_timer[port_no] == 0)) {
+            igmp_router_timer[port_no] = 0;
+            WRITE_PORT_BIT_MASK(port_no, 0, &igmp_router_mask);
+            changed = TRUE;
+        }
+    }
+    if (changed) {
+        igmp_router_commit();
+    }
+    if (igmp_full_timer && --igmp_full_timer == 0) {
+        igmp_flood_commit();
+    }
+
+    for (idx = 0, grp = igmp_groups; idx < IGMP_GROUP_MAX; idx++, grp++) {
+        if (!grp->group) {
+            continue;
+        }
+        changed = FALSE;
+        for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+            if (grp->timer[port_no] &&
+                (!TEST_PORT_BIT_MASK(port_no, &link_mask) ||
+                 --grp->timer[port_no] == 0)) {
+                grp->timer[port_no] = 0;
+                changed = TRUE;
+            }
+        }
+        if (changed) {
+            igmp_group_commit(idx);
+        }
+    }
+}
+
+/* ************************************************************************ */
+bool h2_igmp_group_get (uchar idx, igmp_group_info_t xdata *info)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get group number idx of the IGMP_GROUP_MAX ones.
+ * Remarks     : Returns FALSE if the entry is free.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    if (idx >= IGMP_GROUP_MAX || !igmp_groups[idx].group) {
+        return FALSE;
+    }
+    info->group   = igmp_groups[idx].group;
+    info->vid     = igmp_groups[idx].vid;
+    info->members = igmp_group_members(idx);
+    return TRUE;
+}
+
+port_bit_mask_t h2_igmp_router_ports_get (void)
+{
+    return igmp_router_mask;
+}
+
+ulong h2_igmp_cnt_get (uchar cnt)
+{
+    return igmp_cnt[cnt];
+}
+
+void h2_igmp_cnt_clear (void)
+{
+    memset(igmp_cnt, 0, sizeof(igmp_cnt));
+}
+
+/*****************************************************************************
+ *
+ *
+ * Support functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Add a listener port, groups 224.0.0.x are always flooded */
+static void igmp_join (ulong group, ushort vid, uchar port_no)
+{
+    uchar idx;
+    uchar was;
+
+    if ((group & 0xf0000000) != 0xe0000000 || (group & 0xffffff00) == 0xe0000000) {
+        return;
+    }
+    idx = igmp_group_find(group, vid);
+    if (idx == IGMP_GROUP_MAX) {
+        /* Take a free entry */
+        for (idx = 0; idx < IGMP_GROUP_MAX && igmp_groups[idx].group; idx++) {
+        }
+        if (idx == IGMP_GROUP_MAX) {
+            /* The group has listeners but no entry, flood until they could
+               have left, so they do not lose the group */
+            igmp_cnt[IGMP_CNT_FULL]++;
+            was = igmp_full_timer;
+            igmp_full_timer = IGMP_TICKS(IGMP_MEMBER_TIMEOUT);
+            if (!was) {
+                igmp_flood_commit();
+            }
+            return;
+        }
+        igmp_groups[idx].group = group;
+        igmp_groups[idx].vid   = vid;
+    }
+    was = igmp_groups[idx].timer[port_no];
+    igmp_groups[idx].timer[port_no] = IGMP_TICKS(IGMP_MEMBER_TIMEOUT);
+    if (!was) {
+        igmp_group_commit(idx);
+    }
+}
+
+/* Let the listeners of a port go, unless they report again in time */
+static void igmp_leave (ulong group, ushort vid, uchar port_no)
+{
+    uchar idx;
+
+    idx = igmp_group_find(group, vid);
+    if (idx == IGMP_GROUP_MAX || !igmp_groups[idx].timer[port_no]) {
+        return;
+    }
+#if IGMP_LEAVE_TIMEOUT
+    if (igmp_groups[idx].timer[port_no] > IGMP_TICKS(IGMP_LEAVE_TIMEOUT)) {
+        igmp_groups[idx].timer[port_no] = IGMP_TICKS(IGMP_LEAVE_TIMEOUT);
+    }
+#else
+    igmp_groups[idx].timer[port_no] = 0;
+    igmp_group_commit(idx);
+#endif
+}
+
+/* Index of a group in use, IGMP_GROUP_MAX if not found */
+static uchar igmp_group_find (ulong group, ushort vid)
+{
+    uchar idx;
+
+    for (idx = 0; idx < IGMP_GROUP_MAX; idx++) {
+        if (igmp_groups[idx].group == group && igmp_groups[idx].vid == vid) {
+            break;
+        }
+    }
+    return idx;
+}
+
+static port_bit_mask_t igmp_group_members (uchar idx)
+{
+    port_bit_mask_t mask;
+    uchar           port_no;
+
+    mask = 0;
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (igmp_groups[idx].timer[port_no]) {
+            WRITE_PORT_BIT_MASK(port_no, 1, &mask);
+        }
+    }
+    return mask;
+}
+
+/*
+ * Program the MAC table entry of a group after its listeners changed, and
+ * free the group if none are left. 32 groups share each multicast MAC
+ * address, so the entry forwards to the listeners of all groups in use
+ * with the same address and VID, using the PGID of the first of them.
+ */
+static void igmp_group_commit (uchar idx)
+{
+    mac_addr_t      xdata mac;
+    port_bit_mask_t mask;
+    ulong           addr;
+    ushort          vid;
+    uchar           i, first;
+
+    addr = igmp_groups[idx].group & 0x007fffff;
+    vid  = igmp_groups[idx].vid;
+    if (!igmp_group_members(idx)) {
+        igmp_groups[idx].group = 0;
+    }
+
+    mask  = 0;
+    first = IGMP_GROUP_MAX;
+    for (i = 0; i < IGMP_GROUP_MAX; i++) {
+        if (igmp_groups[i].group && igmp_groups[i].vid == vid &&
+            (igmp_groups[i].group & 0x007fffff) == addr) {
+            mask |= igmp_group_members(i);
+            if (first == IGMP_GROUP_MAX) {
+                first = i;
+            }
+        }
+    }
+
+    mac[0] = 0x01;
+    mac[1] = 0x00;
+    mac[2] = 0x5e;
+    mac[3] = (uchar) (addr >> 16);
+    mac[4] = (uchar) (addr >> 8);
+    mac[5] = (uchar) addr;
+    if (first == IGMP_GROUP_MAX) {
+        h2_mactab_static_del(mac, vid);
+    } else {
+        H2_WRITE(VTSS_ANA_ANA_TABLES_PGID(IGMP_PGID_START + first), mask | igmp_router_mask);
+        h2_mactab_static_add(mac, vid, IGMP_PGID_START + first);
+    }
+}
+
+/* Router ports receive all multicast, update the PGIDs after a change */
+static void igmp_router_commit (void)
+{
+    uchar idx;
+
+    H2_WRITE(VTSS_ANA_ANA_TABLES_PGID(IGMP_PGID_UNREG), igmp_router_mask);
+    igmp_flood_commit();
+
+    for (idx = 0; idx < IGMP_GROUP_MAX; idx++) {
+        if (igmp_groups[idx].group) {
+            igmp_group_commit(idx);
+        }
+    }
+}
+
+/* Unregistered IPv4 multicast goes to the router ports only, unless there
+   are none or groups did not fit in the table */
+static void igmp_flood_commit (void)
+{
+#if IGMP_UNREG_FLOOD
+    H2_WRITE_MASKED(VTSS_ANA_ANA_FLOODING_IPMC,
+                    VTSS_F_ANA_ANA_FLOODING_IPMC_FLD_MC4_DATA(IGMP_PGID_FLOOD),
+                    VTSS_M_ANA_ANA_FLOODING_IPMC_FLD_MC4_DATA);
+#else
+    H2_WRITE_MASKED(VTSS_ANA_ANA_FLOODING_IPMC,
+                    VTSS_F_ANA_ANA_FLOODING_IPMC_FLD_MC4_DATA(igmp_router_mask && !igmp_full_timer ?
+                                                              IGMP_PGID_UNREG : IGMP_PGID_FLOOD),
+                    VTSS_M_ANA_ANA_FLOODING_IPMC_FLD_MC4_DATA);
+#endif
+}
+
+/* Send a frame to the ports of mask with link, except the ingress port */
+static void igmp_forward (vtss_rx_frame_t xdata *frame, ushort length,
+                          port_bit_mask_t mask)
+{
+    uchar port_no;
+
+    mask &= phy_get_link_mask();
+    WRITE_PORT_BIT_MASK(frame->header.port, 0, &mask);
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        if (TEST_PORT_BIT_MASK(port_no, &mask)) {
+            (void) h2_tx_frame_port(port_no, frame->rx_packet, length, VTSS_VID_NULL);
+        }
+    }
+}
+
+/* Check the Internet checksum of an IGMP message */
+static bool igmp_csum_ok (const uchar xdata *igmp, ushort length)
+{
+    ulong sum;
+
+    sum = 0;
+    for (; length > 1; length -= 2, igmp += 2) {
+        sum += *(ushort xdata *) igmp;
+    }
+    if (length) {
+        sum += (ushort) *igmp << 8;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum == 0xffff;
+}
+
+#endif /* TRANSIT_IGMP_SNOOP */
@@ -0,0 +1,38 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+#ifndef __H2IGMP_H__
+#define __H2IGMP_H__
+
+#include "h2packet.h"
+
+#if TRANSIT_IGMP_SNOOP
+
+/* Counters of h2_igmp_cnt_get() */
+#define IGMP_CNT_QUERY      0   /* Queries received */
+#define IGMP_CNT_REPORT     1   /* IGMPv1/v2 membership reports */
+#define IGMP_CNT_V3_REPORT  2   /* IGMPv3 membership reports */
+#define IGMP_CNT_LEAVE      3   /* IGMPv2 leave group messages */
+#define IGMP_CNT_INVALID    4   /* Malformed frames, not forwarded */
+#define IGMP_CNT_FULL       5   /* Joins lost, IGMP_GROUP_MAX groups in use */
+#define IGMP_CNT_CNT        6
+
+/* A group in use, as returned by h2_igmp_group_get() */
+typedef struct {
+    ulong           group;      /* IPv4 group address */
+    ushort          vid;
+    port_bit_mask_t members;    /* Chip ports with listeners */
+} igmp_group_info_t;
+
+void   h2_igmp_init (void);
+void   h2_igmp_frame_received (vtss_rx_frame_t xdata *frame);
+void   h2_igmp_1sec (void);
+bool   h2_igmp_group_get (uchar idx, igmp_group_info_t xdata *info);
+port_bit_mask_t h2_igmp_router_ports_get (void);
+ulong  h2_igmp_cnt_get (uchar cnt);
+void   h2_igmp_cnt_clear (void);
+
+#endif /* TRANSIT_IGMP_SNOOP */
+
+#endif
@@ -36,22 +36,36 @@ void  h2_write_masked (ulong addr, ulong value, ulong mask) small;
  * enable reentrant to make things more complex
  ****************************************************************************/
 
+/* Count of protected register accesses, used by the CPU tx/rx benchmark.
+   A masked write is a read followed by a write and counts twice. The
+   interrupt handlers restore the count on exit, so only accesses made
+   outside interrupt context are counted. */
+#if LOOPBACK_TEST
+extern ulong xdata h2_access_cnt;
+#define H2_ACCESS_COUNT(n) h2_access_cnt += (n)
+#else
+#define H2_ACCESS_COUNT(n)
+#endif
+
 /* void H2_READ(ulong addr, ulong value); */
 #define H2_READ(addr, value) \
 {EA=0; \
 (value) = h2_read((addr)); \
+H2_ACCESS_COUNT(1); \
 EA=1;}
 
 /* void H2_WRITE(ulong addr, ulong value); */
 #define H2_WRITE(addr, value) \
 {EA=0; \
 h2_write((addr), (value)); \
+H2_ACCESS_COUNT(1); \
 EA=1;}
 
 /* void H2_WRITE_MASKED(ulong addr, ulong value, ulong mask); */
 #define H2_WRITE_MASKED(addr, value, mask) \
 {EA=0; \
 h2_write_masked ((addr),(value),(mask)); \
+H2_ACCESS_COUNT(2); \
 EA=1;}
 
 
@@ -45,6 +45,10 @@
  *
  ****************************************************************************/
 
+#if LOOPBACK_TEST
+ulong xdata h2_access_cnt = 0;
+#endif /* LOOPBACK_TEST */
+
 /* ************************************************************************ */
 void h2_write_masked (ulong addr, ulong value, ulong mask) small
 /* ------------------------------------------------------------------------ --
@@ -10,6 +10,11 @@
 #include "h2io.h"
 #include "timer.h"
 #include "main.h"
+#include "misc2.h"
+#if TRANSIT_LEARN_LIMIT
+#include "phytsk.h"
+#endif
+#include <string.h>
 
 /*****************************************************************************
  *
@@ -55,7 +60,11 @@
  *
  ****************************************************************************/
 
-static void do_mactab_cmd (ulong mac_access_reg_val);
+static void  mactab_cmd_start (ulong age_filter, ulong mac_access_reg_val);
+static void  mactab_cmd_sync (void);
+static ulong do_mactab_cmd (ulong mac_access_reg_val);
+static void  mactab_addr_set (ushort vid, const uchar xdata *mac);
+static void  mactab_entry_get (ulong access, mactab_entry_t xdata *entry);
 
 /*****************************************************************************
  *
@@ -66,6 +75,40 @@ static void do_mactab_cmd (ulong mac_access_reg_val);
  *
  ****************************************************************************/
 
+/*
+ * Port flushes queued by h2_mactab_flush_port() and run by h2_mactab_cmd_poll(),
+ * one ageing pass at a time. Ports in mactab_flush_mask still need their first
+ * pass, ports in mactab_age_mask only the second one.
+ */
+static port_bit_mask_t xdata mactab_flush_mask;
+static port_bit_mask_t xdata mactab_age_mask;
+static bit                   mactab_cmd_busy;
+
+#if TRANSIT_AGE_ADAPT
+static mactab_age_stat_t xdata mactab_age;
+static uchar             xdata mactab_age_timer;
+#endif
+
+#if TRANSIT_LEARN_LIMIT
+static uchar  xdata learn_limit [MAX_PORT];         /* Configured limit, 2**n entries */
+static uchar  xdata learn_hold [MAX_PORT];          /* Seconds left of a storm hold */
+static ushort xdata learn_cnt [MAX_PORT];           /* Entries at the last check */
+static uchar  xdata learn_grace [MAX_PORT];         /* Seconds left without storm detection */
+static uchar  xdata learn_fast [MAX_PORT];          /* Seconds in a row at the storm rate */
+static ushort xdata learn_storm_cnt [MAX_PORT];     /* Learn storms detected */
+static ulong  xdata learn_disc_last;
+static ulong  xdata learn_disc_cnt;
+static ulong  xdata learn_drop_sec;
+static bit          learn_limit_drop;
+#endif
+
+#if TRANSIT_MACTAB_STAT
+static bit                 mactab_scan_run;
+static ushort        xdata mactab_scan_row;
+static mactab_stat_t xdata mactab_scan_stat;    /* Scan in progress */
+static mactab_stat_t xdata mactab_stat;         /* Last complete scan */
+#endif
+
 /* ************************************************************************ */
 void h2_mactab_agetime_set (void)
 /* ------------------------------------------------------------------------ --
@@ -76,10 +119,13 @@ void h2_mactab_agetime_set (void)
  * Example     :
  ****************************************************************************/
 {
-#define age_time AGEING_TIMEOUT
-
+#if TRANSIT_AGE_ADAPT
+    /* Start from the default, h2_mactab_age_1sec() takes it from there */
+    memset(&mactab_age, 0, sizeof(mactab_age));
+    mactab_age.age_time = AGEING_TIMEOUT;
+#endif
     H2_WRITE(VTSS_ANA_ANA_AUTOAGE,
-             VTSS_F_ANA_ANA_AUTOAGE_AGE_PERIOD((ulong)(age_time/2)));
+             VTSS_F_ANA_ANA_AUTOAGE_AGE_PERIOD((ulong)(AGEING_TIMEOUT/2)));
 }
 
 /* ************************************************************************ */
@@ -92,6 +138,8 @@ void h2_mactab_age (uchar pgid_age, uchar pgid, uchar vid_age, ushort vid)
  * Example     :
  ****************************************************************************/
 {
+    mactab_cmd_sync();
+
     /* Selective aging */
     H2_WRITE(VTSS_ANA_ANA_ANAGEFIL,
            (pgid_age ? VTSS_F_ANA_ANA_ANAGEFIL_PID_EN : 0) |
@@ -119,13 +167,490 @@ void h2_mactab_clear (void)
     do_mactab_cmd(MAC_CMD_TABLE_CLEAR);
 }
 
-
+/* ************************************************************************ */
 void h2_mactab_flush_port (uchar port_no)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Queue removal of the addresses learned on a port.
+ * Remarks     : Returns at once, the flush is done by h2_mactab_cmd_poll().
+ *               Flushing a port already queued costs nothing extra.
+ * Restrictions:
+ * See also    : h2_mactab_cmd_poll()
+ * Example     :
+ ****************************************************************************/
+{
+    WRITE_PORT_BIT_MASK(port_no, 1, &mactab_flush_mask);
+}
+
+/* ************************************************************************ */
+void h2_mactab_cmd_poll (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Complete the running MAC table command and start the next
+ *               queued one, without waiting for the hardware.
+ * Remarks     : To be called from the main loop. Aging twice means flush:
+ *               the first pass marks the entries aged, the second removes
+ *               them. ANAGEFIL holds a single port, so each port gets its
+ *               own two passes, one port completed before the next one is
+ *               started. Repeated flushes of a port still queued are merged.
+ * Restrictions:
+ * See also    : h2_mactab_flush_port()
+ * Example     :
+ ****************************************************************************/
+{
+    ulong  access;
+    uchar  port_no;
+
+    if (mactab_cmd_busy) {
+        H2_READ(VTSS_ANA_ANA_TABLES_MACACCESS, access);
+        if (VTSS_X_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(access) != MAC_CMD_IDLE) {
+            return;
+        }
+        mactab_cmd_busy = 0;
+        /* Clear age filter again to avoid affecting automatic ageing */
+        H2_WRITE(VTSS_ANA_ANA_ANAGEFIL, 0);
+    }
+
+    if (mactab_age_mask) {
+        /* Second pass of the port started */
+        for (port_no = 0; !TEST_PORT_BIT_MASK(port_no, &mactab_age_mask); port_no++)
+            ;
+        WRITE_PORT_BIT_MASK(port_no, 0, &mactab_age_mask);
+    } else if (mactab_flush_mask) {
+        /* First pass of the next port queued */
+        for (port_no = 0; !TEST_PORT_BIT_MASK(port_no, &mactab_flush_mask); port_no++)
+            ;
+        WRITE_PORT_BIT_MASK(port_no, 0, &mactab_flush_mask);
+        WRITE_PORT_BIT_MASK(port_no, 1, &mactab_age_mask);
+    } else {
+        return;
+    }
+    mactab_cmd_start(VTSS_F_ANA_ANA_ANAGEFIL_PID_EN | VTSS_F_ANA_ANA_ANAGEFIL_PID_VAL(port_no),
+                     VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(MAC_CMD_TABLE_AGE));
+}
+
+/* ************************************************************************ */
+uchar h2_mactab_get_next (mactab_cursor_t xdata *cursor, mactab_entry_t xdata *buf, uchar cnt)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Read up to cnt MAC table entries following the cursor, in
+ *               VID and MAC address order.
+ * Remarks     : Returns the number of entries stored in buf and moves the
+ *               cursor past the last one. Less than cnt means the end of the
+ *               table was reached. Each entry costs one GET_NEXT command, so
+ *               a large table can be read a chunk at a time between other
+ *               jobs. Entries learned or aged meanwhile may or may not be
+ *               seen.
+ * Restrictions:
+ * See also    :
+ * Example     : mactab_cursor_t c; mactab_entry_t e[8]; uchar n;
+ *               memset(&c, 0, sizeof(c));
+ *               do { n = h2_mactab_get_next(&c, e, 8); ... } while (n == 8);
+ ****************************************************************************/
+{
+    uchar n;
+    ulong access;
+
+    for (n = 0; n < cnt; n++, buf++) {
+        mactab_addr_set(cursor->vid, cursor->mac);
+        access = do_mactab_cmd(VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(MAC_CMD_GET_NEXT));
+        if (!(access & VTSS_F_ANA_ANA_TABLES_MACACCESS_VALID)) {
+            break;
+        }
+        mactab_entry_get(access, buf);
+        cursor->vid = buf->vid;
+        memcpy(cursor->mac, buf->mac, sizeof(mac_addr_t));
+    }
+    return n;
+}
+
+#if TRANSIT_IGMP_SNOOP
+/* ************************************************************************ */
+void h2_mactab_static_add (const uchar xdata *mac, ushort vid, uchar pgid)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Add or update a locked entry forwarding to a PGID.
+ * Remarks     : Locked entries are never aged or flushed. For multicast
+ *               addresses pgid is a destination mask, see
+ *               ANA:ANA_TABLES:PGID.
+ * Restrictions: pgid must be below 64.
+ * See also    : h2_mactab_static_del()
+ * Example     :
+ ****************************************************************************/
+{
+    mactab_addr_set(vid, mac);
+    do_mactab_cmd(VTSS_F_ANA_ANA_TABLES_MACACCESS_VALID |
+                  VTSS_F_ANA_ANA_TABLES_MACACCESS_ENTRY_TYPE(MAC_TYPE_LOCKED) |
+                  VTSS_F_ANA_ANA_TABLES_MACACCESS_DEST_IDX(pgid) |
+                  VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(MAC_CMD_LEARN));
+}
+
+/* ************************************************************************ */
+void h2_mactab_static_del (const uchar xdata *mac, ushort vid)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Remove the entry of an address, locked or not.
+ * Remarks     : Nothing happens if there is no such entry.
+ * Restrictions:
+ * See also    : h2_mactab_static_add()
+ * Example     :
+ ****************************************************************************/
+{
+    mactab_addr_set(vid, mac);
+    do_mactab_cmd(VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(MAC_CMD_FORGET));
+}
+#endif /* TRANSIT_IGMP_SNOOP */
+
+#if TRANSIT_MACTAB_STAT
+/* ************************************************************************ */
+void h2_mactab_scan_start (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Start a sweep of the MAC table by h2_mactab_scan().
+ * Remarks     : Does nothing if a sweep is already running.
+ * Restrictions:
+ * See also    : h2_mactab_stat_get()
+ * Example     :
+ ****************************************************************************/
+{
+    if (!mactab_scan_run) {
+        memset(&mactab_scan_stat, 0, sizeof(mactab_scan_stat));
+        mactab_scan_row = 0;
+        mactab_scan_run = 1;
+    }
+}
+
+/* ************************************************************************ */
+void h2_mactab_scan (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Read the next MACTAB_SCAN_ROWS rows of the MAC table by index
+ *               and update the statistics.
+ * Remarks     : To be called every 10 msec. Only reads the table while a
+ *               sweep started by h2_mactab_scan_start() is running. When
+ *               the last row has been read the statistics are published,
+ *               see h2_mactab_stat_get().
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
 {
-    // age twice means flush
-    h2_mactab_age(1, port_no, 0, 0);
-    h2_mactab_age(1, port_no, 0, 0);
+    uchar  rows;
+    uchar  bucket;
+    uchar  used;
+    uchar  pgid;
+    ulong  access;
+
+    /* Leave the table to a running flush, try again next time */
+    if (!mactab_scan_run || mactab_cmd_busy) {
+        return;
+    }
+
+    for (rows = MACTAB_SCAN_ROWS; rows; rows--) {
+        used = 0;
+        for (bucket = 0; bucket < MACTAB_BUCKETS; bucket++) {
+            H2_WRITE(VTSS_ANA_ANA_TABLES_MACTINDX,
+                     VTSS_F_ANA_ANA_TABLES_MACTINDX_BUCKET(bucket) |
+                     VTSS_F_ANA_ANA_TABLES_MACTINDX_M_INDEX(mactab_scan_row));
+            access = do_mactab_cmd(VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(MAC_CMD_READ));
+            if (!(access & VTSS_F_ANA_ANA_TABLES_MACACCESS_VALID)) {
+                continue;
+            }
+            used++;
+            pgid = VTSS_X_ANA_ANA_TABLES_MACACCESS_DEST_IDX(access);
+            if (VTSS_X_ANA_ANA_TABLES_MACACCESS_ENTRY_TYPE(access) >= MAC_TYPE_IPV4_MC ||
+                pgid > LUTON26_ICPU_PORT) {
+                /* Entries forwarding to a mask, e.g. of IGMP snooping */
+                mactab_scan_stat.mc_cnt++;
+                continue;
+            }
+            if (VTSS_X_ANA_ANA_TABLES_MACACCESS_ENTRY_TYPE(access) == MAC_TYPE_LOCKED) {
+                mactab_scan_stat.static_cnt++;
+            } else {
+                mactab_scan_stat.dynamic_cnt++;
+            }
+            mactab_scan_stat.port_cnt[pgid]++;
+        }
+        mactab_scan_stat.row_cnt[used]++;
+
+        if (++mactab_scan_row == MACTAB_ROWS) {
+            /* Did a full row make learning fail since the last scan? */
+            H2_READ(VTSS_ANA_ANA_ANEVENTS, access);
+            if (access & VTSS_F_ANA_ANA_ANEVENTS_AUTO_LEARN_FAILED) {
+                H2_WRITE(VTSS_ANA_ANA_ANEVENTS, VTSS_F_ANA_ANA_ANEVENTS_AUTO_LEARN_FAILED);
+                mactab_scan_stat.learn_fail_cnt = mactab_stat.learn_fail_cnt + 1;
+            } else {
+                mactab_scan_stat.learn_fail_cnt = mactab_stat.learn_fail_cnt;
+            }
+            mactab_scan_stat.scan_cnt = mactab_stat.scan_cnt + 1;
+            mactab_stat = mactab_scan_stat;
+            mactab_scan_run = 0;
+            return;
+        }
+    }
+}
+
+/* ************************************************************************ */
+void h2_mactab_stat_get (mactab_stat_t xdata *stat)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the statistics of the last complete MAC table scan.
+ * Remarks     : All zeros until the first scan started by
+ *               h2_mactab_scan_start() has completed. The row counts
+ *               show the hash pressure: a new address whose row is full
+ *               cannot be learned, and frames to it are flooded.
+ * Restrictions:
+ * See also    : h2_mactab_scan()
+ * Example     :
+ ****************************************************************************/
+{
+    *stat = mactab_stat;
 }
+#endif /* TRANSIT_MACTAB_STAT */
+
+#if TRANSIT_AGE_ADAPT
+/* ************************************************************************ */
+void h2_mactab_age_1sec (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Adapt the age time to the occupancy of the MAC table.
+ * Remarks     : Every AGE_ADAPT_SEC seconds the learned entries of all ports
+ *               are summed. Above AGE_ADAPT_HIGH the age time is halved,
+ *               below AGE_ADAPT_LOW it is doubled, within AGE_TIME_MIN and
+ *               AGE_TIME_MAX. The gap between the water marks and holding a
+ *               new age time for at least its own length keep it from
+ *               oscillating: entries need one to two age periods to go.
+ * Restrictions: Call once a second.
+ * See also    : h2_mactab_agetime_set()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar  port_no;
+    ushort entries;
+    ulong  val;
+
+    if (mactab_age.hold) {
+        mactab_age.hold--;
+    }
+    if (mactab_age.since != 0xffff) {
+        mactab_age.since++;
+    }
+    if (++mactab_age_timer < AGE_ADAPT_SEC) {
+        return;
+    }
+    mactab_age_timer = 0;
+
+    /* Locked entries are not aged, count the learned ones only */
+    entries = 0;
+    for (port_no = MIN_PORT; port_no <= MAX_PORT; port_no++) {
+        H2_READ(VTSS_ANA_ANA_TABLES_ENTRYLIM(port_no), val);
+        entries += VTSS_X_ANA_ANA_TABLES_ENTRYLIM_ENTRYSTAT(val);
+    }
+    mactab_age.entries = entries;
+
+    if (mactab_age.hold) {
+        return;
+    }
+    if (entries >= AGE_ADAPT_HIGH && mactab_age.age_time > AGE_TIME_MIN) {
+        mactab_age.age_time /= 2;
+        if (mactab_age.age_time < AGE_TIME_MIN) {
+            mactab_age.age_time = AGE_TIME_MIN;
+        }
+        mactab_age.lower_cnt++;
+    } else if (entries <= AGE_ADAPT_LOW && mactab_age.age_time < AGE_TIME_MAX) {
+        mactab_age.age_time *= 2;
+        if (mactab_age.age_time > AGE_TIME_MAX) {
+            mactab_age.age_time = AGE_TIME_MAX;
+        }
+        mactab_age.raise_cnt++;
+    } else {
+        return;
+    }
+    mactab_age.hold           = mactab_age.age_time;
+    mactab_age.since          = 0;
+    mactab_age.change_entries = entries;
+    H2_WRITE(VTSS_ANA_ANA_AUTOAGE,
+             VTSS_F_ANA_ANA_AUTOAGE_AGE_PERIOD((ulong)(mactab_age.age_time / 2)));
+}
+
+void h2_mactab_age_stat_get (mactab_age_stat_t xdata *stat)
+{
+    *stat = mactab_age;
+}
+#endif /* TRANSIT_AGE_ADAPT */
+
+#if TRANSIT_LEARN_LIMIT
+/* ************************************************************************ */
+void h2_mactab_learn_limit_init (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Apply the default learn limit and overflow action to all
+ *               front ports.
+ * Remarks     :
+ * Restrictions: Call after the MAC table has been cleared.
+ * See also    : h2_mactab_learn_limit_set()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar port_no;
+
+    H2_READ(VTSS_ANA_ANA_LEARNDISC, learn_disc_last);
+    h2_mactab_learn_stat_clear();
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        learn_hold[port_no]  = 0;
+        learn_cnt[port_no]   = 0;
+        learn_grace[port_no] = LEARN_STORM_GRACE_SEC;
+        learn_fast[port_no]  = 0;
+        h2_mactab_learn_limit_set(port_no, LEARN_LIMIT_DEFAULT);
+    }
+    h2_mactab_learn_drop_set(LEARN_LIMIT_DROP);
+}
+
+/* ************************************************************************ */
+void h2_mactab_learn_limit_set (uchar port_no, uchar limit)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Limit the unlocked entries learned on a port to 2**limit.
+ * Remarks     : LEARN_LIMIT_NONE or more removes the limit. Entries already
+ *               learned stay until aged. A port held after a learn storm
+ *               gets the new limit when the hold ends.
+ * Restrictions:
+ * See also    : h2_mactab_learn_drop_set()
+ * Example     :
+ ****************************************************************************/
+{
+    if (limit > LEARN_LIMIT_NONE) {
+        limit = LEARN_LIMIT_NONE;
+    }
+    learn_limit[port_no] = limit;
+    if (!learn_hold[port_no]) {
+        H2_WRITE_MASKED(VTSS_ANA_ANA_TABLES_ENTRYLIM(port_no),
+                        VTSS_F_ANA_ANA_TABLES_ENTRYLIM_ENTRYLIM(limit),
+                        VTSS_M_ANA_ANA_TABLES_ENTRYLIM_ENTRYLIM);
+    }
+}
+
+uchar h2_mactab_learn_limit_get (uchar port_no)
+{
+    return learn_limit[port_no];
+}
+
+/* ************************************************************************ */
+void h2_mactab_learn_drop_set (bool drop)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Select what happens to frames from a new station on a port
+ *               that has reached its learn limit.
+ * Remarks     : drop = TRUE discards them, drop = FALSE forwards them, and
+ *               frames to the station are flooded as it is not learned.
+ * Restrictions:
+ * See also    : h2_mactab_learn_limit_set()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar port_no;
+
+    learn_limit_drop = drop;
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        H2_WRITE_MASKED(VTSS_ANA_PORT_PORT_CFG(port_no),
+                        drop ? VTSS_F_ANA_PORT_PORT_CFG_LIMIT_DROP : 0,
+                        VTSS_F_ANA_PORT_PORT_CFG_LIMIT_DROP);
+    }
+}
+
+bool h2_mactab_learn_drop_get (void)
+{
+    return learn_limit_drop;
+}
+
+/* ************************************************************************ */
+void h2_mactab_learn_1sec (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Monitor the learn rate of the ports and the learn discards.
+ * Remarks     : A port whose entry count grew by LEARN_STORM_RATE or more
+ *               each second for LEARN_STORM_SEC seconds in a row is flushed
+ *               and held at a limit of 2**LEARN_STORM_LIMIT for
+ *               LEARN_STORM_HOLD_SEC seconds, so the random addresses of a
+ *               storm or loop do not evict the stations of the other ports.
+ *               The first LEARN_STORM_GRACE_SEC seconds after link up are
+ *               not checked, as a switch or uplink connected to the port
+ *               then learns its stations at once.
+ * Restrictions: Call once a second.
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    port_bit_mask_t link_mask;
+    uchar           port_no;
+    ushort          cnt;
+    ulong           val;
+
+    link_mask = phy_get_link_mask();
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        H2_READ(VTSS_ANA_ANA_TABLES_ENTRYLIM(port_no), val);
+        cnt = VTSS_X_ANA_ANA_TABLES_ENTRYLIM_ENTRYSTAT(val);
+        if (!TEST_PORT_BIT_MASK(port_no, &link_mask)) {
+            learn_grace[port_no] = LEARN_STORM_GRACE_SEC;
+            learn_fast[port_no]  = 0;
+        }
+        if (learn_hold[port_no]) {
+            if (--learn_hold[port_no] == 0) {
+                h2_mactab_learn_limit_set(port_no, learn_limit[port_no]);
+            }
+        } else if (learn_grace[port_no]) {
+            learn_grace[port_no]--;
+        } else if (LEARN_STORM_RATE && cnt >= learn_cnt[port_no] + LEARN_STORM_RATE) {
+            if (++learn_fast[port_no] >= LEARN_STORM_SEC) {
+                learn_fast[port_no] = 0;
+                learn_storm_cnt[port_no]++;
+                learn_hold[port_no] = LEARN_STORM_HOLD_SEC;
+                H2_WRITE_MASKED(VTSS_ANA_ANA_TABLES_ENTRYLIM(port_no),
+                                VTSS_F_ANA_ANA_TABLES_ENTRYLIM_ENTRYLIM(LEARN_STORM_LIMIT),
+                                VTSS_M_ANA_ANA_TABLES_ENTRYLIM_ENTRYLIM);
+                h2_mactab_flush_port(port_no);
+            }
+        } else {
+            learn_fast[port_no] = 0;
+        }
+        learn_cnt[port_no] = cnt;
+    }
+
+    /* Learn frames discarded for lack of room in the table */
+    H2_READ(VTSS_ANA_ANA_LEARNDISC, val);
+    learn_disc_cnt += val - learn_disc_last;
+    learn_disc_last = val;
+
+    /* The hardware only has a sticky bit for learn limit drops */
+    H2_READ(VTSS_ANA_ANA_ANEVENTS, val);
+    if (val & VTSS_F_ANA_ANA_ANEVENTS_LEARN_DROP) {
+        H2_WRITE(VTSS_ANA_ANA_ANEVENTS, VTSS_F_ANA_ANA_ANEVENTS_LEARN_DROP);
+        learn_drop_sec++;
+    }
+}
+
+ushort h2_mactab_learn_cnt_get (uchar port_no)
+{
+    ulong val;
+
+    H2_READ(VTSS_ANA_ANA_TABLES_ENTRYLIM(port_no), val);
+    return VTSS_X_ANA_ANA_TABLES_ENTRYLIM_ENTRYSTAT(val);
+}
+
+ushort h2_mactab_learn_storm_get (uchar port_no)
+{
+    return learn_storm_cnt[port_no];
+}
+
+uchar h2_mactab_learn_hold_get (uchar port_no)
+{
+    return learn_hold[port_no];
+}
+
+ulong h2_mactab_learn_disc_get (void)
+{
+    return learn_disc_cnt;
+}
+
+ulong h2_mactab_learn_drop_sec_get (void)
+{
+    return learn_drop_sec;
+}
+
+void h2_mactab_learn_stat_clear (void)
+{
+    memset(learn_storm_cnt, 0, sizeof(learn_storm_cnt));
+    learn_disc_cnt = 0;
+    learn_drop_sec = 0;
+}
+#endif /* TRANSIT_LEARN_LIMIT */
 
 /*****************************************************************************
  *
@@ -135,12 +660,82 @@ void h2_mactab_flush_port (uchar port_no)
  *
  *
  ****************************************************************************/
-static void do_mactab_cmd (ulong mac_access_reg_val)
+static void mactab_cmd_start (ulong age_filter, ulong mac_access_reg_val)
+{
+    H2_WRITE(VTSS_ANA_ANA_ANAGEFIL, age_filter);
+    H2_WRITE(VTSS_ANA_ANA_TABLES_MACACCESS, mac_access_reg_val);
+    mactab_cmd_busy = 1;
+}
+
+/* Wait for a command started by h2_mactab_cmd_poll() */
+static void mactab_cmd_sync (void)
+{
+    ulong cmd;
+
+    if (mactab_cmd_busy) {
+        do {
+            H2_READ(VTSS_ANA_ANA_TABLES_MACACCESS, cmd);
+        } while (VTSS_X_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(cmd) != MAC_CMD_IDLE);
+        mactab_cmd_busy = 0;
+        H2_WRITE(VTSS_ANA_ANA_ANAGEFIL, 0);
+    }
+}
+
+static ulong do_mactab_cmd (ulong mac_access_reg_val)
 {
     ulong cmd;
+
+    mactab_cmd_sync();
     H2_WRITE(VTSS_ANA_ANA_TABLES_MACACCESS,  mac_access_reg_val);
     do {
         H2_READ(VTSS_ANA_ANA_TABLES_MACACCESS, cmd);
     } while (VTSS_X_ANA_ANA_TABLES_MACACCESS_MAC_TABLE_CMD(cmd) != MAC_CMD_IDLE);
+    return cmd;
+}
+
+static void mactab_addr_set (ushort vid, const uchar xdata *mac)
+{
+    H2_WRITE(VTSS_ANA_ANA_TABLES_MACHDATA,
+             VTSS_F_ANA_ANA_TABLES_MACHDATA_VID(vid) |
+             ((ulong) mac[0] << 8) | mac[1]);
+    H2_WRITE(VTSS_ANA_ANA_TABLES_MACLDATA,
+             ((ulong) mac[2] << 24) | ((ulong) mac[3] << 16) |
+             ((ushort) mac[4] << 8) | mac[5]);
+}
+
+static void mactab_entry_get (ulong access, mactab_entry_t xdata *entry)
+{
+    ulong mach, macl;
+
+    H2_READ(VTSS_ANA_ANA_TABLES_MACHDATA, mach);
+    H2_READ(VTSS_ANA_ANA_TABLES_MACLDATA, macl);
+
+    entry->vid    = VTSS_X_ANA_ANA_TABLES_MACHDATA_VID(mach);
+    entry->mac[0] = (uchar) (mach >> 8);
+    entry->mac[1] = (uchar) mach;
+    entry->mac[2] = (uchar) (macl >> 24);
+    entry->mac[3] = (uchar) (macl >> 16);
+    entry->mac[4] = (uchar) (macl >> 8);
+    entry->mac[5] = (uchar) macl;
+    entry->pgid   = VTSS_X_ANA_ANA_TABLES_MACACCESS_DEST_IDX(access);
+    entry->flags  = 0;
+    switch (VTSS_X_ANA_ANA_TABLES_MACACCESS_ENTRY_TYPE(access)) {
+    case MAC_TYPE_LOCKED:
+        entry->flags |= MACTAB_FLAG_STATIC;
+        if (entry->mac[0] & 0x01) {
+            entry->flags |= MACTAB_FLAG_MC; /* Locked multicast, e.g. IGMP */
+        }
+        break;
+    case MAC_TYPE_IPV4_MC:
+    case MAC_TYPE_IPV6_MC:
+        entry->flags |= MACTAB_FLAG_MC;
+        break;
+    }
+    if (access & VTSS_F_ANA_ANA_TABLES_MACACCESS_AGED_FLAG) {
+        entry->flags |= MACTAB_FLAG_AGED;
+    }
+    if (access & VTSS_F_ANA_ANA_TABLES_MACACCESS_MAC_CPU_COPY) {
+        entry->flags |= MACTAB_FLAG_CPU_COPY;
+    }
 }
 
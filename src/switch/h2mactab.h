@@ -5,10 +5,94 @@
 #ifndef __H2MACTAB_H__
 #define __H2MACTAB_H__
 
+/* Hash rows of the MAC table, each with MACTAB_BUCKETS entries */
+#define MACTAB_ROWS     2048
+#define MACTAB_BUCKETS  4
+
+/* Flags of a MAC table entry */
+#define MACTAB_FLAG_STATIC      0x01    /* Locked, never aged */
+#define MACTAB_FLAG_AGED        0x02    /* Not seen since last ageing */
+#define MACTAB_FLAG_MC          0x04    /* IPv4/IPv6 multicast, pgid is not a port */
+#define MACTAB_FLAG_CPU_COPY    0x08    /* Frames are copied to the CPU */
+
+/* A MAC table entry, as returned by h2_mactab_get_next() */
+typedef struct {
+    ushort     vid;
+    mac_addr_t mac;
+    uchar      pgid;    /* Destination, the chip port of unicast entries */
+    uchar      flags;   /* MACTAB_FLAG_xxx */
+} mactab_entry_t;
+
+/* Where h2_mactab_get_next() goes on from, all zeros to start */
+typedef struct {
+    ushort     vid;
+    mac_addr_t mac;
+} mactab_cursor_t;
+
+#if TRANSIT_MACTAB_STAT
+/* Result of a complete scan of the MAC table by h2_mactab_scan() */
+typedef struct {
+    ushort port_cnt [LUTON26_ICPU_PORT + 1];   /* Unicast entries per chip port */
+    ushort static_cnt;                          /* Locked unicast entries */
+    ushort dynamic_cnt;                         /* Learned unicast entries */
+    ushort mc_cnt;                              /* IPv4/IPv6 multicast entries */
+    ushort row_cnt [MACTAB_BUCKETS + 1];        /* Rows with 0 to 4 buckets used */
+    ushort learn_fail_cnt;                      /* Scans that saw a learn fail */
+    ushort scan_cnt;                            /* Scans completed */
+} mactab_stat_t;
+#endif
+
+#if TRANSIT_AGE_ADAPT
+/* State of the adaptive ageing, see h2_mactab_age_1sec() */
+typedef struct {
+    ushort age_time;        /* Current age time in seconds */
+    ushort entries;         /* Learned entries at the last sample */
+    ushort hold;            /* Seconds before the age time may change again */
+    ushort since;           /* Seconds since the last change, saturates */
+    ushort change_entries;  /* Learned entries that caused the last change */
+    ushort lower_cnt;       /* Times the age time was halved */
+    ushort raise_cnt;       /* Times the age time was doubled */
+} mactab_age_stat_t;
+#endif
+
+#if TRANSIT_LEARN_LIMIT
+/* Learn limit of a port is 2**limit entries, this one means no limit */
+#define LEARN_LIMIT_NONE        13
+#endif
+
 void   h2_mactab_agetime_set (void);
 void   h2_mactab_flush_port (uchar port_no);
 void   h2_mactab_age (uchar pgid_age, uchar pgid, uchar vid_age, ushort vid);
 void   h2_mactab_clear (void);
+void   h2_mactab_cmd_poll (void);
+uchar  h2_mactab_get_next (mactab_cursor_t xdata *cursor, mactab_entry_t xdata *buf, uchar cnt);
+#if TRANSIT_IGMP_SNOOP
+void   h2_mactab_static_add (const uchar xdata *mac, ushort vid, uchar pgid);
+void   h2_mactab_static_del (const uchar xdata *mac, ushort vid);
+#endif
+#if TRANSIT_MACTAB_STAT
+void   h2_mactab_scan_start (void);
+void   h2_mactab_scan (void);
+void   h2_mactab_stat_get (mactab_stat_t xdata *stat);
+#endif
+#if TRANSIT_AGE_ADAPT
+void   h2_mactab_age_1sec (void);
+void   h2_mactab_age_stat_get (mactab_age_stat_t xdata *stat);
+#endif
+#if TRANSIT_LEARN_LIMIT
+void   h2_mactab_learn_limit_init (void);
+void   h2_mactab_learn_limit_set (uchar port_no, uchar limit);
+uchar  h2_mactab_learn_limit_get (uchar port_no);
+void   h2_mactab_learn_drop_set (bool drop);
+bool   h2_mactab_learn_drop_get (void);
+void   h2_mactab_learn_1sec (void);
+ushort h2_mactab_learn_cnt_get (uchar port_no);
+ushort h2_mactab_learn_storm_get (uchar port_no);
+uchar  h2_mactab_learn_hold_get (uchar port_no);
+ulong  h2_mactab_learn_disc_get (void);
+ulong  h2_mactab_learn_drop_sec_get (void);
+void   h2_mactab_learn_stat_clear (void);
+#endif
 
 #endif
 
@@ -91,8 +91,16 @@ typedef struct {
     uchar  xdata            *rx_packet;   /**< packet body */
 } vtss_rx_frame_t;
 
+/** \brief A piece of a frame sent via h2_tx_frame_sg. */
+typedef struct {
+    const uchar             *buf;         /**< fragment bytes */
+    ushort                  len;          /**< number of bytes */
+} vtss_tx_frag_t;
+
 
-#define RECV_BUFSIZE 1514
+/* Longest frame received, incl. FCS: a 1500 byte LLDPDU or IGMPv3 report
+   with a C-tag */
+#define RECV_BUFSIZE 1522
 
 /** \brief Representation of a 48-bit Ethernet address. */
 typedef struct vtss_eth_addr_t {
@@ -111,6 +119,7 @@ typedef struct vtss_eth_hdr_t {
 #define VTSS_ETHTYPE_SLOW 0x8809
 #define VTSS_ETHTYPE_IP6  0x86dd
 #define VTSS_ETHTYPE_LLDP 0x88CC
+#define VTSS_ETHTYPE_CTAG 0x8100
 
 
 #define HTONS(n) (n) /* 8051 uses big order */
@@ -198,7 +207,11 @@ typedef struct {
 #define PACKET_XTR_QU_STACK  PACKET_XTR_QU_HIGH
 #define PACKET_XTR_QU_BPDU_LLDP PACKET_XTR_QU_MEDIUM_HIGH
 #define PACKET_XTR_QU_BPDU   PACKET_XTR_QU_MEDIUM
+#if TRANSIT_IGMP_SNOOP
+#define PACKET_XTR_QU_IGMP   PACKET_XTR_QU_MEDIUM_LOW /* Own queue, parsed in full */
+#else
 #define PACKET_XTR_QU_IGMP   PACKET_XTR_QU_MEDIUM
+#endif
 #define PACKET_XTR_QU_IP     PACKET_XTR_QU_NORMAL
 #define PACKET_XTR_QU_MGMT_MAC PACKET_XTR_QU_NORMAL /* For the switch's own MAC address                */
 #define PACKET_XTR_QU_MAC      PACKET_XTR_QU_LOW    /* For other MAC addresses that require CPU copies */
@@ -249,6 +249,30 @@ void h2_pcs1g_clock_stop (uchar port_no)
     H2_WRITE_MASKED(VTSS_DEV_PORT_MODE_CLOCK_CFG(tgt), 0x00000038, 0x0000003b);
 }
 
+/* ************************************************************************ */
+uchar h2_pcs1g_sync_status_get (const uchar port_no)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the current (not sticky) PCS synchronization status
+ * Remarks     : Returns TRUE if the PCS is in sync. The sticky bits used by
+ *               the link status functions are left untouched.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ulong value;
+    ulong tgt    = VTSS_TO_DEV(port_no);
+    uchar mac_if = phy_map_miim_no(port_no);
+
+    if (mac_if == MAC_IF_SERDES || mac_if == MAC_IF_SGMII || mac_if == MAC_IF_SERDES_2_5G) {
+        H2_READ(VTSS_DEV_PCS1G_CFG_STATUS_PCS1G_LINK_STATUS(tgt), value);
+        return BF(VTSS_F_DEV_PCS1G_CFG_STATUS_PCS1G_LINK_STATUS_SYNC_STATUS, value);
+    }
+
+    H2_READ(VTSS_DEV_PCS_FX100_STATUS_PCS_FX100_STATUS(tgt), value);
+    return BF(VTSS_F_DEV_PCS_FX100_STATUS_PCS_FX100_STATUS_SYNC_STATUS, value);
+}
+
 /* ************************************************************************ */
 void h2_pcs1g_setup (uchar port_no, uchar mode)
 /* ------------------------------------------------------------------------ --
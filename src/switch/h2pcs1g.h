@@ -22,6 +22,7 @@ uchar h2_pcs1g_2_5g_link_status_get(const uchar port_no);
 void  h2_pcs1g_clause_37_control_set(const uchar port_no);
 uchar h2_pcs1g_clause_37_status_get(const uchar port_no);
 uchar h2_pcs1g_100fx_status_get(const uchar port_no);
+uchar h2_pcs1g_sync_status_get(const uchar port_no);
 void  h2_pcs1g_clock_stop (uchar port_no);
 void  h2_pcs1g_setup (uchar port_no, uchar mode);
 #endif
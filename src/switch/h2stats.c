@@ -9,6 +9,10 @@
 #include "h2stats.h"
 #include "txt.h"
 #include "print.h"
+#if TRANSIT_PORT_RATE
+#include "phytsk.h"
+#endif
+#include <string.h>
 
 /*****************************************************************************
  *
@@ -19,6 +23,22 @@
  *
  ****************************************************************************/
 
+/* Counters per port in the RX, TX and drop ranges of SYS:STAT:CNT */
+#define STATS_RX_RANGE      43
+#define STATS_TX_RANGE      31
+#define STATS_DROP_RANGE    18
+
+#if TRANSIT_STATS_64
+/* Counters accumulated to 64 bits, see stats_acc_id[] */
+#define STATS_ACC_CNT   8
+#endif
+
+#if TRANSIT_DROP_STAT
+/* RES_STAT of the port reservations of buffer memory, laid out as
+   RES_CFG in _l26_buf_conf_set() */
+#define STATS_RES_PORT_BUF_I    224
+#define STATS_RES_PORT_BUF_E    (512 + 224)
+#endif
 
 /*****************************************************************************
  *
@@ -49,44 +69,89 @@
  ****************************************************************************/
 
 
-static const ushort tx_counters[6] = {  CNT_TX_64,
-                                        CNT_TX_65_TO_127,
-                                        CNT_TX_128_TO_255,
-                                        CNT_TX_256_TO_511,
-                                        CNT_TX_512_TO_1023,
-                                        CNT_TX_1024_TO_1526 };
+#if TRANSIT_STATS_64
+/* The counters that may wrap within hours. Each frame counter is the sum of
+   the size counters, whose 32-bit sum wraps like a counter of its own. */
+static code port_statistics_t stats_acc_id [STATS_ACC_CNT] = {
+    CNT_RX_OCTETS, CNT_RX_PKTS, CNT_RX_MCAST_PKTS, CNT_RX_BCAST_PKTS,
+    CNT_TX_OCTETS, CNT_TX_PKTS, CNT_TX_MCAST_PKTS, CNT_TX_BCAST_PKTS
+};
 
+/* lo is the hardware value at the last read, hi counts its wraps */
+static stat_cnt64_t xdata stats_acc [MAX_PORT][STATS_ACC_CNT];
+static uchar        xdata stats_poll_port;
+#endif
 
-static const ushort rx_counters[6] = {  CNT_RX_64,
-                                        CNT_RX_65_TO_127,
-                                        CNT_RX_128_TO_255,
-                                        CNT_RX_256_TO_511,
-                                        CNT_RX_512_TO_1023,
-                                        CNT_RX_1024_TO_1526 };
+#if TRANSIT_PORT_RATE
+/* Counters the rates are derived from, in the order of STATS_RATE_xxx */
+static code port_statistics_t rate_cnt_id [STATS_RATE_CNT] = {
+    CNT_RX_PKTS, CNT_RX_OCTETS, CNT_TX_PKTS, CNT_TX_OCTETS
+};
+
+/* Link speeds of LINK_MODE_SPEED_xxx in units of 1% */
+static code ulong rate_speed_pct [4] = {
+    100000UL, 1000000UL, 10000000UL, 25000000UL
+};
+
+static ulong       xdata rate_last [MAX_PORT][STATS_RATE_CNT];  /* Counters at the last sample */
+static ushort      xdata rate_tick [MAX_PORT];                  /* stats_tick at the last sample */
+static port_rate_t xdata rate_avg [MAX_PORT];
+static port_rate_t xdata rate_peak [MAX_PORT];
+static ulong       xdata stats_tick;                            /* Calls of h2_stats_poll() */
+#endif
 
-static ulong h2_stats_counter_get_private (
-    uchar               port_no,
-    port_statistics_t   counter_id
-)
-{
-    ulong               temp, tgt, port_offset;
+#if TRANSIT_DROP_STAT
+/* Counters the drop rates are derived from, in the order of STATS_DROP_xxx */
+static code port_statistics_t drop_cnt_id [STATS_DROP_CAUSE_CNT] = {
+    CNT_DROP_TAIL, CNT_DROP_LOCAL, CNT_TX_AGED, CNT_RX_PAUSE, CNT_TX_PAUSE
+};
+
+static ulong        xdata drop_last [MAX_PORT][STATS_DROP_CAUSE_CNT];
+static port_drop_t  xdata drop_avg [MAX_PORT];
+static port_drop_t  xdata drop_peak [MAX_PORT];
+static port_buf_t   xdata drop_buf_peak [MAX_PORT];
+static drop_event_t xdata drop_event [DROP_EVENT_MAX];              /* Ring of events */
+static uchar        xdata drop_event_next;                          /* Index of the next event */
+static uchar        xdata drop_event_cnt;
+static buf_usage_t  xdata buf_usage;
+#endif
 
-    /* Reserved */
-    if (counter_id >= 0x7000)
-        return 0;
+/* Address of a counter of a port */
+static ulong stats_cnt_addr (uchar port_no, port_statistics_t counter_id)
+{
+    ushort port_offset;
 
-    if (counter_id >= 0xC00)
-        port_offset = 18UL * ((ulong) port_no);
-    else if (counter_id >= 0x800)
-        port_offset = 31UL * ((ulong) port_no);
+    if (counter_id >= CNT_DROP_LOCAL)
+        port_offset = STATS_DROP_RANGE * (ushort) port_no;
+    else if (counter_id >= CNT_TX_OCTETS)
+        port_offset = STATS_TX_RANGE * (ushort) port_no;
     else
-        port_offset = 43UL * ((ulong) port_no);
+        port_offset = STATS_RX_RANGE * (ushort) port_no;
+
+    return VTSS_SYS_STAT_CNT(counter_id + port_offset);
+}
+
+/* Read cnt consecutive counters */
+static void stats_read_range (ulong addr, ulong xdata *buf, uchar cnt)
+{
+    for (; cnt; cnt--, addr += 4, buf++) {
+        H2_READ(addr, *buf);
+    }
+}
 
-    tgt = VTSS_SYS_STAT_CNT(counter_id + port_offset);
+/*
+ * For Luton26 there is no counter that counts all frames,
+ * so we have to calculate it from the 6 size counters.
+ */
+static ulong stats_size_sum (const ulong xdata *size_cnt)
+{
+    ulong cnt;
+    uchar i;
 
-    H2_READ(tgt, temp);
+    for (i = 0, cnt = 0; i < 6; i++)
+        cnt += size_cnt[i];
 
-    return temp;
+    return cnt;
 }
 
 ulong h2_stats_counter_get (
@@ -94,30 +159,472 @@ ulong h2_stats_counter_get (
     port_statistics_t   counter_id
 )
 {
+    ulong xdata         size_cnt [6];
     ulong               cnt;
-    uchar               i;
-    ushort              *p;
 
-    if (counter_id == CNT_TX_PKTS)
-        p = &tx_counters[0];
-    else
+    /* Reserved */
+    if (counter_id >= 0x7000)
+        return 0;
+
+    if (counter_id == CNT_RX_PKTS || counter_id == CNT_TX_PKTS) {
+        stats_read_range(stats_cnt_addr(port_no, counter_id == CNT_RX_PKTS ? CNT_RX_64 : CNT_TX_64),
+                         size_cnt, 6);
+        return stats_size_sum(size_cnt);
+    }
+
+    H2_READ(stats_cnt_addr(port_no, counter_id), cnt);
+    return cnt;
+}
+
+/* ************************************************************************ */
+void h2_stats_snapshot_get (uchar port_no, port_stats_t xdata *snap)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Read all counters of a port in one pass.
+ * Remarks     : Each range of SYS:STAT:CNT is read with consecutive
+ *               addresses, and the frame counts are summed once. With
+ *               TRANSIT_STATS_64 the 64-bit counters are brought up to date
+ *               as well.
+ * Restrictions:
+ * See also    : h2_stats_snapshot_cnt(), h2_stats_snapshot_get_64()
+ * Example     :
+ ****************************************************************************/
+{
+#if TRANSIT_STATS_64
+    stat_cnt64_t xdata *acc;
+    ulong              cnt;
+    uchar              idx;
+#endif
+
+    stats_read_range(stats_cnt_addr(port_no, CNT_RX_OCTETS), snap->rx, STATS_RX_CNT);
+    stats_read_range(stats_cnt_addr(port_no, CNT_TX_OCTETS), snap->tx, STATS_TX_CNT);
+    H2_READ(stats_cnt_addr(port_no, CNT_TX_AGED), snap->tx_aged);
+    stats_read_range(stats_cnt_addr(port_no, CNT_DROP_LOCAL), snap->drop, STATS_DROP_CNT);
+    snap->rx_pkts = stats_size_sum(&snap->rx[CNT_RX_64 - CNT_RX_OCTETS]);
+    snap->tx_pkts = stats_size_sum(&snap->tx[CNT_TX_64 - CNT_TX_OCTETS]);
+
+#if TRANSIT_STATS_64
+    if (port_no >= MAX_PORT) {
+        return;
+    }
+    for (idx = 0, acc = stats_acc[port_no]; idx < STATS_ACC_CNT; idx++, acc++) {
+        cnt = h2_stats_snapshot_cnt(snap, stats_acc_id[idx]);
+        if (cnt < acc->lo) {
+            acc->hi++;
+        }
+        acc->lo = cnt;
+    }
+#endif
+}
+
+/* ************************************************************************ */
+ulong h2_stats_snapshot_cnt (const port_stats_t xdata *snap, port_statistics_t counter_id)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get a counter from a snapshot.
+ * Remarks     : Returns 0 for counters not in the snapshot.
+ * Restrictions:
+ * See also    : h2_stats_snapshot_get()
+ * Example     :
+ ****************************************************************************/
+{
     if (counter_id == CNT_RX_PKTS)
-        p = &rx_counters[0];
-    else {
-        return h2_stats_counter_get_private( port_no, counter_id);
+        return snap->rx_pkts;
+    if (counter_id == CNT_TX_PKTS)
+        return snap->tx_pkts;
+    if (counter_id == CNT_TX_AGED)
+        return snap->tx_aged;
+    if (counter_id < CNT_RX_OCTETS + STATS_RX_CNT)
+        return snap->rx[counter_id - CNT_RX_OCTETS];
+    if (counter_id >= CNT_TX_OCTETS && counter_id < CNT_TX_OCTETS + STATS_TX_CNT)
+        return snap->tx[counter_id - CNT_TX_OCTETS];
+    if (counter_id >= CNT_DROP_LOCAL && counter_id < CNT_DROP_LOCAL + STATS_DROP_CNT)
+        return snap->drop[counter_id - CNT_DROP_LOCAL];
+    return 0;
+}
+
+/* ************************************************************************ */
+void h2_stats_snapshot_get_64 (uchar port_no, const port_stats_t xdata *snap,
+                               port_statistics_t counter_id, stat_cnt64_t xdata *cnt)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get a counter from a snapshot, 64 bits wide for the
+ *               accumulated ones.
+ * Remarks     : The octet, frame, multicast and broadcast counters of front
+ *               ports are accumulated, the others are returned with hi 0.
+ * Restrictions: snap must be the latest snapshot of port_no.
+ * See also    : h2_stats_poll()
+ * Example     :
+ ****************************************************************************/
+{
+#if TRANSIT_STATS_64
+    uchar idx;
+
+    if (port_no < MAX_PORT) {
+        for (idx = 0; idx < STATS_ACC_CNT; idx++) {
+            if (stats_acc_id[idx] == counter_id) {
+                *cnt = stats_acc[port_no][idx];
+                return;
+            }
+        }
     }
+#else
+    port_no = port_no;
+#endif
+    cnt->hi = 0;
+    cnt->lo = h2_stats_snapshot_cnt(snap, counter_id);
+}
 
-    /*
-     * For Luton26 there is no counter that counts all frames,
-     * so we have to calculate it ourselves.
-     */
+#if TRANSIT_PORT_RATE
+/* Count per second of a counter that increased delta in interval polls */
+static ulong stats_per_sec (ulong delta, ushort interval)
+{
+    /* Without overflowing 32 bits */
+    if (delta < 0x19999999UL) {
+        return delta * 10 / interval;
+    }
+    return delta / interval * 10;
+}
 
-    for (i = 0, cnt = 0; i < 6; i++)
-        cnt += h2_stats_counter_get_private( port_no, p[i] );
+/* Add a sample to an average and a peak */
+static void stats_rate_sample (ulong xdata *avg, ulong xdata *peak, ulong rate)
+{
+    /* avg += (rate - avg) / 2**STATS_RATE_EWMA_SHIFT */
+    if (rate >= *avg) {
+        *avg += (rate - *avg) >> STATS_RATE_EWMA_SHIFT;
+    } else {
+        *avg -= (*avg - rate) >> STATS_RATE_EWMA_SHIFT;
+    }
+    if (rate > *peak) {
+        *peak = rate;
+    }
+}
 
-    return cnt;
+#if TRANSIT_DROP_STAT
+/*
+ * Sample the drop rates and the buffer use of a port, and record an event
+ * if frames were lost for lack of buffer. An event is extended as long as
+ * each sample of the port has losses.
+ */
+static void stats_drop_update (uchar port_no, const port_stats_t xdata *snap, ushort interval)
+{
+    drop_event_t xdata *ev;
+    port_buf_t         buf;
+    ulong              cnt;
+    ulong              delta;
+    ulong              drops;
+    uchar              i;
+
+    /* MAXUSE is the highest use since the last read, i.e. the last sample */
+    H2_READ(VTSS_SYS_RES_CTRL_RES_STAT(STATS_RES_PORT_BUF_I + port_no), cnt);
+    buf.ingress = VTSS_X_SYS_RES_CTRL_RES_STAT_MAXUSE(cnt);
+    H2_READ(VTSS_SYS_RES_CTRL_RES_STAT(STATS_RES_PORT_BUF_E + port_no), cnt);
+    buf.egress = VTSS_X_SYS_RES_CTRL_RES_STAT_MAXUSE(cnt);
+    if (buf.ingress > drop_buf_peak[port_no].ingress) {
+        drop_buf_peak[port_no].ingress = buf.ingress;
+    }
+    if (buf.egress > drop_buf_peak[port_no].egress) {
+        drop_buf_peak[port_no].egress = buf.egress;
+    }
+
+    for (i = 0, drops = 0; i < STATS_DROP_CAUSE_CNT; i++) {
+        cnt   = h2_stats_snapshot_cnt(snap, drop_cnt_id[i]);
+        delta = cnt - drop_last[port_no][i];
+        drop_last[port_no][i] = cnt;
+        if (interval == 0) {
+            continue;
+        }
+        if (i == STATS_DROP_TAIL || i == STATS_DROP_AGED) {
+            drops += delta;
+        }
+        stats_rate_sample(&drop_avg[port_no].rate[i], &drop_peak[port_no].rate[i],
+                          stats_per_sec(delta, interval));
+    }
+    if (drops == 0) {
+        return;
+    }
+
+    /* Extend the event of the port's previous sample, or start a new one */
+    ev = &drop_event[(drop_event_next + DROP_EVENT_MAX - 1) % DROP_EVENT_MAX];
+    if (drop_event_cnt == 0 || ev->port_no != port_no || ev->tick_last != stats_tick - interval) {
+        ev = &drop_event[drop_event_next];
+        drop_event_next = (drop_event_next + 1) % DROP_EVENT_MAX;
+        if (drop_event_cnt < DROP_EVENT_MAX) {
+            drop_event_cnt++;
+        }
+        memset(ev, 0, sizeof(*ev));
+        ev->port_no    = port_no;
+        ev->tick_first = stats_tick;
+    }
+    ev->tick_last = stats_tick;
+    ev->drops += drops;
+    if (buf_usage.used > ev->buf_used) {
+        ev->buf_used = buf_usage.used;
+    }
+    if (buf.ingress > ev->port_buf.ingress) {
+        ev->port_buf.ingress = buf.ingress;
+    }
+    if (buf.egress > ev->port_buf.egress) {
+        ev->port_buf.egress = buf.egress;
+    }
 }
 
+/* Sample the use of the switch buffer */
+static void stats_buf_update (void)
+{
+    ulong  reg;
+    ushort free;
+
+    H2_READ(VTSS_SYS_MMGT_MMGT, reg);
+    free = VTSS_X_SYS_MMGT_MMGT_FREECNT(reg);
+    buf_usage.used = free < buf_usage.total ? buf_usage.total - free : 0;
+    if (buf_usage.used > buf_usage.peak) {
+        buf_usage.peak      = buf_usage.used;
+        buf_usage.peak_tick = stats_tick;
+    }
+}
+#endif /* TRANSIT_DROP_STAT */
+
+/*
+ * Derive the rates of a port from the counters read since the last sample,
+ * stats_tick - rate_tick[] polls of 100 msec ago.
+ */
+static void stats_rate_update (uchar port_no, const port_stats_t xdata *snap)
+{
+    ulong  cnt;
+    ulong  rate;
+    ushort interval;
+    uchar  i;
+
+    interval = (ushort) stats_tick - rate_tick[port_no];
+    rate_tick[port_no] = (ushort) stats_tick;
+
+    for (i = 0; i < STATS_RATE_CNT; i++) {
+        cnt  = h2_stats_snapshot_cnt(snap, rate_cnt_id[i]);
+        rate = cnt - rate_last[port_no][i];
+        rate_last[port_no][i] = cnt;
+        if (interval == 0) {
+            continue;
+        }
+
+        rate = stats_per_sec(rate, interval);
+        if (rate_cnt_id[i] == CNT_RX_OCTETS || rate_cnt_id[i] == CNT_TX_OCTETS) {
+            rate *= 8;
+        }
+        stats_rate_sample(&rate_avg[port_no].val[i], &rate_peak[port_no].val[i], rate);
+    }
+#if TRANSIT_DROP_STAT
+    stats_drop_update(port_no, snap, interval);
+#endif
+}
+
+/* ************************************************************************ */
+void h2_stats_rate_get (uchar port_no, port_rate_t xdata *avg, port_rate_t xdata *peak)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the average and peak rates of a port.
+ * Remarks     : The average is exponentially weighted, each sample counting
+ *               1/2**STATS_RATE_EWMA_SHIFT. A sample is taken each time
+ *               h2_stats_poll() reads the port. The peak is the highest
+ *               sample since h2_stats_rate_peak_clear(). avg or peak may be
+ *               NULL.
+ * Restrictions:
+ * See also    : h2_stats_load_get()
+ * Example     :
+ ****************************************************************************/
+{
+    if (avg) {
+        *avg = rate_avg[port_no];
+    }
+    if (peak) {
+        *peak = rate_peak[port_no];
+    }
+}
+
+/* ************************************************************************ */
+uchar h2_stats_load_get (uchar port_no)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the load of a port in percent of its link speed.
+ * Remarks     : The higher of the average RX and TX bit rates, 0 without
+ *               link. A load signal for e.g. EEE or loop detection.
+ * Restrictions:
+ * See also    : h2_stats_rate_get()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar link_mode;
+    ulong bps;
+
+    link_mode = phy_get_link_mode_raw(port_no);
+    if (link_mode == LINK_MODE_DOWN) {
+        return 0;
+    }
+    bps = rate_avg[port_no].val[STATS_RATE_RX_BPS];
+    if (rate_avg[port_no].val[STATS_RATE_TX_BPS] > bps) {
+        bps = rate_avg[port_no].val[STATS_RATE_TX_BPS];
+    }
+    bps /= rate_speed_pct[link_mode & LINK_MODE_SPEED_MASK];
+    return bps > 100 ? 100 : (uchar) bps;
+}
+
+void h2_stats_rate_peak_clear (void)
+{
+    memset(rate_peak, 0, sizeof(rate_peak));
+}
+#endif /* TRANSIT_PORT_RATE */
+
+#if TRANSIT_DROP_STAT
+/* ************************************************************************ */
+void h2_stats_drop_get (uchar port_no, port_drop_t xdata *avg, port_drop_t xdata *peak)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the average and peak drop rates of a port.
+ * Remarks     : Sampled and averaged as the port rates. avg or peak may be
+ *               NULL.
+ * Restrictions:
+ * See also    : h2_stats_rate_get()
+ * Example     :
+ ****************************************************************************/
+{
+    if (avg) {
+        *avg = drop_avg[port_no];
+    }
+    if (peak) {
+        *peak = drop_peak[port_no];
+    }
+}
+
+/* ************************************************************************ */
+void h2_stats_buf_get (uchar port_no, port_buf_t xdata *peak)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the highest use of a port's buffer reservations.
+ * Remarks     : Highest since h2_stats_drop_clear(), in units of 48 bytes.
+ *               Use beyond the reservation is taken from the shared buffer,
+ *               and is not included.
+ * Restrictions:
+ * See also    : h2_stats_buf_usage_get()
+ * Example     :
+ ****************************************************************************/
+{
+    *peak = drop_buf_peak[port_no];
+}
+
+void h2_stats_buf_usage_get (buf_usage_t xdata *usage)
+{
+    *usage = buf_usage;
+    usage->tick = stats_tick;
+}
+
+/* ************************************************************************ */
+bool h2_stats_drop_event_get (uchar idx, drop_event_t xdata *ev)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get a recorded congestion event.
+ * Remarks     : idx 0 is the latest event. Returns FALSE if there are no
+ *               more events.
+ * Restrictions:
+ * See also    : h2_stats_buf_usage_get() for the current tick.
+ * Example     :
+ ****************************************************************************/
+{
+    if (idx >= drop_event_cnt) {
+        return FALSE;
+    }
+    *ev = drop_event[(drop_event_next + DROP_EVENT_MAX - 1 - idx) % DROP_EVENT_MAX];
+    return TRUE;
+}
+
+/* ************************************************************************ */
+void h2_stats_drop_clear (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Clear the peak drop rates, the buffer peaks and the events.
+ * Remarks     : The averages and the current use are kept.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    memset(drop_peak, 0, sizeof(drop_peak));
+    memset(drop_buf_peak, 0, sizeof(drop_buf_peak));
+    drop_event_next = 0;
+    drop_event_cnt  = 0;
+    buf_usage.peak      = buf_usage.used;
+    buf_usage.peak_tick = stats_tick;
+}
+#endif /* TRANSIT_DROP_STAT */
+
+#if TRANSIT_STATS_64
+/* ************************************************************************ */
+void h2_stats_init (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Start the 64-bit counters from the hardware counters.
+ * Remarks     : With TRANSIT_DROP_STAT the free buffer is taken as the
+ *               size of the switch buffer.
+ * Restrictions: To be called after h2_init().
+ * See also    : h2_stats_poll()
+ * Example     :
+ ****************************************************************************/
+{
+    port_stats_t xdata snap;
+    uchar              port_no;
+#if TRANSIT_DROP_STAT
+    ulong              reg;
+#endif
+
+    memset(stats_acc, 0, sizeof(stats_acc));
+#if TRANSIT_PORT_RATE
+    memset(rate_tick, 0, sizeof(rate_tick));
+    memset(rate_avg, 0, sizeof(rate_avg));
+    memset(rate_peak, 0, sizeof(rate_peak));
+    stats_tick = 0;
+#endif
+#if TRANSIT_DROP_STAT
+    memset(drop_avg, 0, sizeof(drop_avg));
+    memset(&buf_usage, 0, sizeof(buf_usage));
+    h2_stats_drop_clear();
+
+    /* Nothing is queued this soon after the ports are set up */
+    H2_READ(VTSS_SYS_MMGT_MMGT, reg);
+    buf_usage.total = VTSS_X_SYS_MMGT_MMGT_FREECNT(reg);
+#endif
+    for (port_no = MIN_PORT; port_no < MAX_PORT; port_no++) {
+        h2_stats_snapshot_get(port_no, &snap);
+#if TRANSIT_PORT_RATE
+        stats_rate_update(port_no, &snap);
+#endif
+    }
+    stats_poll_port = MIN_PORT;
+}
+
+/* ************************************************************************ */
+void h2_stats_poll (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Read the counters of the next STATS_POLL_PORTS ports and
+ *               count the wraps since the last read. With TRANSIT_PORT_RATE
+ *               the rates of the ports are sampled as well, and with
+ *               TRANSIT_DROP_STAT their drops and the buffer use.
+ * Remarks     : Each port must be read within the time its fastest counter
+ *               takes to wrap, 34 sec for the octets of a 1 Gbps port.
+ * Restrictions: To be called every 100 msec.
+ * See also    : h2_stats_snapshot_get_64()
+ * Example     :
+ ****************************************************************************/
+{
+    port_stats_t xdata snap;
+    uchar              n;
+
+#if TRANSIT_PORT_RATE
+    stats_tick++;
+#endif
+#if TRANSIT_DROP_STAT
+    stats_buf_update();
+#endif
+    for (n = 0; n < STATS_POLL_PORTS; n++) {
+        h2_stats_snapshot_get(stats_poll_port, &snap);
+#if TRANSIT_PORT_RATE
+        stats_rate_update(stats_poll_port, &snap);
+#endif
+        if (++stats_poll_port == MAX_PORT) {
+            stats_poll_port = MIN_PORT;
+        }
+    }
+}
+#endif /* TRANSIT_STATS_64 */
+
 #if UNMANAGED_PORT_STATISTICS_IF
 /* ************************************************************************ */
 void print_port_statistics (uchar port_no)
@@ -169,7 +676,10 @@ void print_port_statistics (uchar port_no)
     uchar spaces;
     std_txt_t tx_txt_no;
     ulong reg_addr;
-    ulong reg_val;
+    stat_cnt64_t xdata reg_val;
+    port_stats_t xdata snap;
+
+    h2_stats_snapshot_get(port_no, &snap);
 
     for (j = 0; j < NO_OF_LINES; j++) {
 
@@ -223,8 +733,8 @@ void print_port_statistics (uchar port_no)
             print_txt(prefix_txt[c & 0x01]);
             print_txt_left(display_tab_1[j].txt_no[c], 23);
             if (reg_addr != COUNTER_NONE) {
-                reg_val = h2_stats_counter_get(port_no, reg_addr);
-                print_dec_right(reg_val);
+                h2_stats_snapshot_get_64(port_no, &snap, reg_addr, &reg_val);
+                print_dec_64_nright(reg_val.hi, reg_val.lo, 10);
             } else {
                 print_str("         -");
             }
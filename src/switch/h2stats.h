@@ -75,8 +75,103 @@ typedef enum _port_statistics_t {
 
     COUNTER_NONE            = 0xffff,
 } port_statistics_t;
+
+/* A 64-bit counter value, see h2_stats_snapshot_get_64() */
+typedef struct {
+    ulong hi;
+    ulong lo;
+} stat_cnt64_t;
+
+/* Counters of each range in a snapshot */
+#define STATS_RX_CNT    (CNT_RX_CAT_DROP - CNT_RX_OCTETS + 1)
+#define STATS_TX_CNT    (CNT_TX_OVERSIZE_PKTS - CNT_TX_OCTETS + 1)
+#define STATS_DROP_CNT  (CNT_DROP_TAIL - CNT_DROP_LOCAL + 1)
+
+/* All counters of a port, as read by h2_stats_snapshot_get() */
+typedef struct {
+    ulong rx [STATS_RX_CNT];        /* CNT_RX_OCTETS to CNT_RX_CAT_DROP */
+    ulong tx [STATS_TX_CNT];        /* CNT_TX_OCTETS to CNT_TX_OVERSIZE_PKTS */
+    ulong tx_aged;                  /* CNT_TX_AGED */
+    ulong drop [STATS_DROP_CNT];    /* CNT_DROP_LOCAL and CNT_DROP_TAIL */
+    ulong rx_pkts;                  /* CNT_RX_PKTS, sum of the size counters */
+    ulong tx_pkts;                  /* CNT_TX_PKTS, sum of the size counters */
+} port_stats_t;
+
+#if TRANSIT_PORT_RATE
+/* Rates of a port_rate_t */
+#define STATS_RATE_RX_FPS   0   /* Frames per second */
+#define STATS_RATE_RX_BPS   1   /* Bits per second */
+#define STATS_RATE_TX_FPS   2
+#define STATS_RATE_TX_BPS   3
+#define STATS_RATE_CNT      4
+
+typedef struct {
+    ulong val [STATS_RATE_CNT];
+} port_rate_t;
+#endif
+
+#if TRANSIT_DROP_STAT
+/* Causes of a port_drop_t */
+#define STATS_DROP_TAIL         0   /* Ingress, out of buffer (CNT_DROP_TAIL) */
+#define STATS_DROP_LOCAL        1   /* Ingress, no destination (CNT_DROP_LOCAL) */
+#define STATS_DROP_AGED         2   /* Egress, aged in a queue (CNT_TX_AGED) */
+#define STATS_DROP_RX_PAUSE     3   /* Pause frames received, egress held back */
+#define STATS_DROP_TX_PAUSE     4   /* Pause frames sent, ingress congested */
+#define STATS_DROP_CAUSE_CNT    5
+
+/* Frames per second of each cause */
+typedef struct {
+    ulong rate [STATS_DROP_CAUSE_CNT];
+} port_drop_t;
+
+/* Use of a port's buffer reservations, in units of 48 bytes */
+typedef struct {
+    ushort ingress;
+    ushort egress;
+} port_buf_t;
+
+/* Use of the switch buffer, in units of 192 bytes */
+typedef struct {
+    ushort total;           /* Free when idle */
+    ushort used;            /* At the last h2_stats_poll() */
+    ushort peak;            /* Highest since h2_stats_drop_clear() */
+    ulong  peak_tick;       /* h2_stats_poll() call of the peak */
+    ulong  tick;            /* h2_stats_poll() calls, 100 msec each */
+} buf_usage_t;
+
+/* Samples of a port in a row with tail drops or aged frames */
+typedef struct {
+    ulong  tick_first;      /* h2_stats_poll() call of the first sample */
+    ulong  tick_last;       /* and of the last */
+    ulong  drops;           /* Tail dropped and aged frames */
+    ushort buf_used;        /* Highest switch buffer use seen, 192 bytes units */
+    port_buf_t port_buf;    /* Highest port reservation use seen */
+    uchar  port_no;
+} drop_event_t;
+#endif
+
 uchar h2_stats_counter_exists (port_statistics_t counter_id);
 ulong h2_stats_counter_get (uchar port_no, port_statistics_t counter_id);
+void  h2_stats_snapshot_get (uchar port_no, port_stats_t xdata *snap);
+ulong h2_stats_snapshot_cnt (const port_stats_t xdata *snap, port_statistics_t counter_id);
+void  h2_stats_snapshot_get_64 (uchar port_no, const port_stats_t xdata *snap,
+                                port_statistics_t counter_id, stat_cnt64_t xdata *cnt);
+#if TRANSIT_STATS_64
+void  h2_stats_init (void);
+void  h2_stats_poll (void);
+#endif
+#if TRANSIT_PORT_RATE
+void  h2_stats_rate_get (uchar port_no, port_rate_t xdata *avg, port_rate_t xdata *peak);
+uchar h2_stats_load_get (uchar port_no);
+void  h2_stats_rate_peak_clear (void);
+#endif
+#if TRANSIT_DROP_STAT
+void  h2_stats_drop_get (uchar port_no, port_drop_t xdata *avg, port_drop_t xdata *peak);
+void  h2_stats_buf_get (uchar port_no, port_buf_t xdata *peak);
+void  h2_stats_buf_usage_get (buf_usage_t xdata *usage);
+bool  h2_stats_drop_event_get (uchar idx, drop_event_t xdata *ev);
+void  h2_stats_drop_clear (void);
+#endif
 void  print_port_statistics (uchar port_no);
 #endif
 
@@ -18,6 +18,15 @@
 #include "taskdef.h"
 #include "vtss_common_os.h"
 #include "lldp.h"
+#if TRANSIT_CPU_POLICING
+#include "spiflash.h"
+#endif
+#if USE_FDMA_XTR || USE_FDMA_INJ
+#include "h2fdma.h"
+#endif
+#if TRANSIT_IGMP_SNOOP
+#include "h2igmp.h"
+#endif
 
 #if TRANSIT_LLDP || LOOPBACK_TEST || TRANSIT_VERIPHY
 #define __BASIC_TX_RX__ 1
@@ -44,6 +53,31 @@
 #define CPU_INJ_REG		0 /* CPU Injection GRP - register based */
 #define CPU_INJ_DMA		1 /* CPU Injection GRP - DMA based */
 
+/* PRUNE_SIZE n keeps 4 * n + 4 bytes incl. the 8 byte IFH, at most 1024 */
+#define RX_PRUNE_SIZE(bytes)    ((bytes) ? ((bytes) + 7) / 4 : 0)
+
+#if RX_PRUNE_GRP0 > 1016 || RX_PRUNE_GRP1 > 1016 || \
+    (RX_PRUNE_GRP0 && RX_PRUNE_GRP0 < 16) || (RX_PRUNE_GRP1 && RX_PRUNE_GRP1 < 16)
+#error "RX_PRUNE_GRP0/1 must be 0 or in range 16-1016"
+#endif
+
+#if RX_RING_CNT <= RX_BUDGET_GRP0 + RX_BUDGET_GRP1
+#error "RX_RING_CNT must exceed RX_BUDGET_GRP0 + RX_BUDGET_GRP1"
+#endif
+
+/* CPU queues truncated to 92 bytes, all but the ones used for LLDP and IGMP */
+#if TRANSIT_LLDP
+#define RX_TRUNCATE_LLDP_QU     VTSS_BIT(PACKET_XTR_QU_BPDU_LLDP - VTSS_PACKET_RX_QUEUE_START)
+#else
+#define RX_TRUNCATE_LLDP_QU     0
+#endif
+#if TRANSIT_IGMP_SNOOP
+#define RX_TRUNCATE_IGMP_QU     VTSS_BIT(PACKET_XTR_QU_IGMP - VTSS_PACKET_RX_QUEUE_START)
+#else
+#define RX_TRUNCATE_IGMP_QU     0
+#endif
+#define RX_TRUNCATE_QU_MASK     (0xff & ~(RX_TRUNCATE_LLDP_QU | RX_TRUNCATE_IGMP_QU))
+
 /*****************************************************************************
  *
  *
@@ -54,7 +88,7 @@
  ****************************************************************************/
 
 #if __BASIC_TX_RX__
-#define BUF ((vtss_eth_hdr *)&rx_packet[0])
+#define BUF ((vtss_eth_hdr *)frame->rx_packet)
 #endif
 
 /*****************************************************************************
@@ -78,8 +112,14 @@
 
 #if __BASIC_TX_RX__
 
+#if USE_FDMA_XTR
+uchar xdata rx_packet[RECV_BUFSIZE+2+3]; /* The packet buffer that
+                                            contains incoming packets,
+                                            word aligned for MEMACC. */
+#else
 uchar xdata rx_packet[RECV_BUFSIZE+2];   /* The packet buffer that
                                             contains incoming packets. */
+#endif
 vtss_rx_frame_t vtss_rx_frame;
 #endif /* __BASIC_TX_RX__ */
 
@@ -95,9 +135,31 @@ vtss_rx_frame_t vtss_rx_frame;
 static uchar rx_packet_tsk_init = 0;
 vtss_packet_rx_conf_t rx_conf;
 
+#if __BASIC_TX_RX__
+/* Ring of frames extracted but not yet processed, see rx_packet_tsk(). The
+   buffer has room to align each slot to 32 bits for MEMACC. */
+static uchar xdata           rx_ring_buf [RX_RING_CNT * (RECV_BUFSIZE+2) + 3];
+static vtss_rx_frame_t xdata rx_ring [RX_RING_CNT];
+static uchar                 rx_ring_head;      /* Oldest frame */
+static uchar                 rx_ring_cnt;       /* Frames in the ring */
+static uchar                 rx_ring_hwm;       /* Highest rx_ring_cnt seen */
+static ulong xdata           rx_ring_stall_cnt; /* Groups left waiting as the ring was full */
+
+static const uchar code rx_grp_budget [VTSS_PACKET_RX_GROUP_CNT] = {RX_BUDGET_GRP0, RX_BUDGET_GRP1};
+#endif
+
+#if USE_XTR_IRQ
+#define RX_GRP_ALL  ((1 << VTSS_PACKET_RX_GROUP_CNT) - 1)
+
+/* Groups with frames waiting, set by h2_rx_interrupt(). A group stays set,
+   with its XTR_RDY interrupt masked, until rx_packet_tsk() finds it empty. */
+static volatile uchar rx_grp_pending;
+#endif
+
 
 
 #if __BASIC_TX_RX__
+#if 0 //uncall functions
 /* ************************************************************************ */
 void h2_send_frame (uchar port_no, uchar xdata *frame_ptr, ushort frame_len)
 /* ------------------------------------------------------------------------ --
@@ -116,6 +178,7 @@ void h2_send_frame (uchar port_no, uchar xdata *frame_ptr, ushort frame_len)
         ;
     }
 }
+#endif
 
 /*****************************************************************************
  *
@@ -144,6 +207,16 @@ static void h2_rx_grp_conf (void)
     H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_GRP_CFG(0), 0x0);
     H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_GRP_CFG(1), 0x0);
 
+    // Bound the number of words extracted per frame
+    H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_FRM_PRUNING(0),
+             VTSS_F_DEVCPU_QS_XTR_XTR_FRM_PRUNING_PRUNE_SIZE(RX_PRUNE_SIZE(RX_PRUNE_GRP0)));
+    H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_FRM_PRUNING(1),
+             VTSS_F_DEVCPU_QS_XTR_XTR_FRM_PRUNING_PRUNE_SIZE(RX_PRUNE_SIZE(RX_PRUNE_GRP1)));
+#if RX_TRUNCATE_CPU_QU
+    H2_WRITE(VTSS_SYS_SYSTEM_EQ_TRUNCATE(LUTON26_ICPU_PORT),
+             VTSS_F_SYS_SYSTEM_EQ_TRUNCATE_EQ_TRUNCATE(RX_TRUNCATE_QU_MASK));
+#endif
+
 
     /* Enable IFH insertion on CPU ports */
     H2_WRITE_MASKED(VTSS_REW_PORT_PORT_CFG(LUTON26_ICPU_PORT), VTSS_F_REW_PORT_PORT_CFG_IFH_INSERT_ENA,
@@ -360,6 +433,11 @@ void h2_rx_init (void)
         }
 
         conf->grp_map[PACKET_XTR_QU_BPDU_LLDP] = 0;
+#if TRANSIT_IGMP_SNOOP
+        /* IGMP is redirected to the CPU, which forwards it after parsing */
+        conf->grp_map[PACKET_XTR_QU_IGMP] = 0;
+        reg->igmp_cpu_only = 1;
+#endif
 
         /* Setup Rx queue registration */
 #if TRANSIT_BPDU_PASS_THROUGH
@@ -370,7 +448,32 @@ void h2_rx_init (void)
 
         h2_rx_conf_set();
 
+        for (i = 0; i < RX_RING_CNT; i++) {
+            rx_ring[i].rx_packet = rx_ring_buf + ((4 - ((ushort) rx_ring_buf & 3)) & 3) +
+                                   (ushort) i * (RECV_BUFSIZE+2);
+            h2_discard_frame(&rx_ring[i]);
+        }
+        rx_ring_head = 0;
+        rx_ring_cnt = 0;
+
+#if USE_XTR_IRQ
+        /* Let the first pass find each group empty and unmask its interrupt */
+        for (i = VTSS_PACKET_RX_GROUP_START; i < VTSS_PACKET_RX_GROUP_END; i++) {
+            H2_WRITE(VTSS_ICPU_CFG_INTR_XTR_RDY0_INTR_CFG + 4 * i,
+                     VTSS_F_ICPU_CFG_INTR_XTR_RDY0_INTR_CFG_XTR_RDY0_INTR_SEL(0));
+        }
+        rx_grp_pending = RX_GRP_ALL;
+#endif
+
+#if USE_FDMA_XTR
+        vtss_rx_frame.rx_packet = rx_packet + ((4 - ((ushort) rx_packet & 3)) & 3);
+        h2_fdma_xtr_init(rx_ring[0].rx_packet, RX_RING_CNT * (RECV_BUFSIZE+2));
+#else
         vtss_rx_frame.rx_packet = rx_packet;
+#endif
+#if USE_FDMA_INJ
+        h2_fdma_inj_init();
+#endif
         vtss_rx_frame.discard = 1;
         vtss_rx_frame.total_bytes = 0;
         vtss_rx_frame.pruned = 0;
@@ -389,37 +492,315 @@ void h2_rx_init (void)
  ****************************************************************************/
 void rx_packet_tsk (void)
 {
+    vtss_rx_frame_t xdata *frame;
     uchar source_port;
     uchar recv_q;
+    uchar budget;
+#if USE_XTR_IRQ
+    uchar pending;
+#endif
 
+#if USE_FDMA_INJ
+    h2_fdma_inj_poll();
+#endif
+#if USE_XTR_IRQ
+    pending = rx_grp_pending;
+#if USE_FDMA_XTR
+    if (h2_fdma_xtr_active()) {
+        /* The FDMA drains the groups, h2_fdma_xtr_get() knows what is new */
+        pending = RX_GRP_ALL;
+    }
+#endif
+    if (!pending && !rx_ring_cnt) {
+        return;
+    }
+#endif
+    /* Move frames from each extraction group into the ring, up to the
+       budget of the group. Once the ring is full the frames stay in the
+       extraction groups until a later pass. */
     for (recv_q = VTSS_PACKET_RX_GROUP_START; recv_q < VTSS_PACKET_RX_GROUP_END; recv_q++) {
-        h2_rx_frame_get(recv_q, &vtss_rx_frame);
-        if(!vtss_rx_frame.discard && vtss_rx_frame.total_bytes) {
-            source_port = port2ext(vtss_rx_frame.header.port);
-#ifndef VTSS_COMMON_NDEBUG
-            vtss_common_dump_frame(vtss_rx_frame.rx_packet ,vtss_rx_frame.total_bytes);
+#if USE_XTR_IRQ
+        if (!(pending & (1 << recv_q))) {
+            continue;
+        }
 #endif
-            switch (BUF->type) {
-#if TRANSIT_LLDP
-            case HTONS(VTSS_ETHTYPE_LLDP):
-                if (VTSS_COMMON_MACADDR_CMP(BUF->dest.addr, mac_addr_lldp) == 0) {
-                    TASK(SUB_TASK_ID_LLDP_RX, lldp_frame_received(source_port, vtss_rx_frame.rx_packet, vtss_rx_frame.total_bytes));
-                } else {
-                    VTSS_COMMON_TRACE(VTSS_COMMON_TRLVL_NOISE, ("Dropping on port %u type 0x%x len %u\n",
-                                      (unsigned)source_port, (unsigned)BUF->type, (unsigned)rx_packet));
-                    h2_discard_frame(&vtss_rx_frame);
-                }
+        for (budget = rx_grp_budget[recv_q]; budget; budget--) {
+            if (rx_ring_cnt == RX_RING_CNT) {
+                rx_ring_stall_cnt++;
+                break;
+            }
+            frame = &rx_ring[(rx_ring_head + rx_ring_cnt) % RX_RING_CNT];
+            if (!h2_rx_frame_get(recv_q, frame)) {
                 break;
+            }
+            if (!frame->discard && frame->total_bytes) {
+                if (++rx_ring_cnt > rx_ring_hwm) {
+                    rx_ring_hwm = rx_ring_cnt;
+                }
+            }
+        }
+#if USE_XTR_IRQ
+        if (!budget || rx_ring_cnt == RX_RING_CNT
+#if USE_FDMA_XTR
+            || h2_fdma_xtr_active()
 #endif
-            default:
-                VTSS_COMMON_TRACE(VTSS_COMMON_TRLVL_NOISE, ("Dropping on port %u type 0x%x len %u\n",
-                                  (unsigned)source_port, (unsigned)BUF->type, (unsigned)rx_packet));
-                h2_discard_frame(&vtss_rx_frame);
+           ) {
+            continue;   /* More to come, keep the group pending */
+        }
+        /* Group is empty. Clear the sticky event before unmasking it, so a
+           frame arriving in between raises the interrupt again. */
+        EA = 0;
+        rx_grp_pending &= ~(1 << recv_q);
+        EA = 1;
+        H2_WRITE(VTSS_ICPU_CFG_INTR_INTR, VTSS_F_ICPU_CFG_INTR_INTR_XTR_RDY0_INTR << recv_q);
+        H2_WRITE(VTSS_ICPU_CFG_INTR_INTR_ENA_SET, VTSS_F_ICPU_CFG_INTR_INTR_ENA_SET_XTR_RDY0_INTR_ENA_SET << recv_q);
+#endif
+    }
 
+    /* Process the oldest frames */
+    for (budget = RX_PROCESS_BUDGET; budget && rx_ring_cnt; budget--) {
+        frame = &rx_ring[rx_ring_head];
+        source_port = port2ext(frame->header.port);
+#ifndef VTSS_COMMON_NDEBUG
+        vtss_common_dump_frame(frame->rx_packet, frame->total_bytes);
+#endif
+        switch (BUF->type) {
+#if TRANSIT_LLDP
+        case HTONS(VTSS_ETHTYPE_LLDP):
+            if (VTSS_COMMON_MACADDR_CMP(BUF->dest.addr, mac_addr_lldp) == 0) {
+                TASK(SUB_TASK_ID_LLDP_RX, lldp_frame_received(source_port, frame->rx_packet, frame->total_bytes));
+            } else {
+                VTSS_COMMON_TRACE(VTSS_COMMON_TRLVL_NOISE, ("Dropping on port %u type 0x%x len %u\n",
+                                  (unsigned)source_port, (unsigned)BUF->type, (unsigned)frame->total_bytes));
             }
-        } else {
-            ; /* Already discard in function "h2_rx_frame_get" */
+            break;
+#endif
+#if TRANSIT_IGMP_SNOOP
+        case HTONS(VTSS_ETHTYPE_IP):
+        case HTONS(VTSS_ETHTYPE_CTAG):
+            h2_igmp_frame_received(frame);
+            break;
+#endif
+        default:
+            VTSS_COMMON_TRACE(VTSS_COMMON_TRLVL_NOISE, ("Dropping on port %u type 0x%x len %u\n",
+                              (unsigned)source_port, (unsigned)BUF->type, (unsigned)frame->total_bytes));
         }
+        h2_discard_frame(frame);
+        rx_ring_head = (rx_ring_head + 1) % RX_RING_CNT;
+        rx_ring_cnt--;
     }
 }
+
+uchar h2_rx_ring_hwm_get (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the highest number of frames held in the receive ring.
+ * Remarks     : A value of RX_RING_CNT suggests the ring is too small.
+ * Restrictions:
+ * See also    : h2_rx_ring_stall_get()
+ * Example     :
+ ****************************************************************************/
+{
+    return rx_ring_hwm;
+}
+
+ulong h2_rx_ring_stall_get (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the number of times a group was left with frames waiting
+ *               as the receive ring was full.
+ * Remarks     : The frames are read on a later pass, not dropped.
+ * Restrictions:
+ * See also    : h2_rx_ring_hwm_get()
+ * Example     :
+ ****************************************************************************/
+{
+    return rx_ring_stall_cnt;
+}
+
+void h2_rx_ring_stat_clear (void)
+{
+    rx_ring_hwm = rx_ring_cnt;
+    rx_ring_stall_cnt = 0;
+}
 #endif
+
+#if USE_XTR_IRQ
+#pragma NOAREGS
+/* ************************************************************************ */
+void h2_rx_interrupt (ulong ident) small
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Handle the XTR_RDY interrupts of the extraction groups.
+ * Remarks     : Only marks the groups pending and masks their interrupts,
+ *               the frames are read by rx_packet_tsk() once the 8051 wakes
+ *               up from idle.
+ * Restrictions: Only to be called from ext_0_interrupt().
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ident &= VTSS_F_ICPU_CFG_INTR_INTR_XTR_RDY0_INTR | VTSS_F_ICPU_CFG_INTR_INTR_XTR_RDY1_INTR;
+    H2_WRITE(VTSS_ICPU_CFG_INTR_INTR_ENA_CLR, ident);
+    rx_grp_pending |= (uchar) (ident >> 16);
+}
+#pragma AREGS
+#endif
+
+#if TRANSIT_CPU_POLICING
+/*****************************************************************************
+ *
+ *
+ * CPU policing
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Burst of the storm policers, 2^n frames, common for all of them */
+#define CPU_POL_BURST   5
+
+static const ulong code cpu_pol_default_fps [CPU_POL_CNT] = {
+    CPU_POL_UC_FPS, CPU_POL_BC_FPS, CPU_POL_MC_FPS, CPU_POL_LEARN_FPS
+};
+
+static uchar xdata cpu_pol_rate [CPU_POL_CNT];  /* Encoded, see CPU_POL_KILO */
+static ulong xdata cpu_pol_drop_sec;            /* Seconds with policed frames */
+
+static uchar cpu_pol_encode (ulong fps)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Encode a rate as the largest power of two not above it.
+ * Remarks     : Rates above 32768 frames/s are encoded in kiloframes/s.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    ulong unit = 1;
+    uchar rate;
+
+    if (!fps) {
+        return CPU_POL_DISABLED;
+    }
+    if (fps > 32768UL) {
+        unit = 1000;
+    }
+    for (rate = 15; rate && (unit << rate) > fps; rate--) {
+        ;
+    }
+    return (unit == 1) ? rate : (rate | CPU_POL_KILO);
+}
+
+static void cpu_pol_apply (const uchar pol)
+{
+    uchar rate = cpu_pol_rate[pol];
+
+    if (rate & CPU_POL_DISABLED) {
+        H2_WRITE(VTSS_ANA_ANA_STORMLIMIT_CFG(pol), 0);
+    } else {
+        /* Police frames to the CPU only, front port flooding is untouched */
+        H2_WRITE(VTSS_ANA_ANA_STORMLIMIT_CFG(pol),
+                 VTSS_F_ANA_ANA_STORMLIMIT_CFG_STORM_RATE(rate & 0xf) |
+                 ((rate & CPU_POL_KILO) ? 0 : VTSS_F_ANA_ANA_STORMLIMIT_CFG_STORM_UNIT) |
+                 VTSS_F_ANA_ANA_STORMLIMIT_CFG_STORM_MODE(1));
+    }
+}
+
+/* ************************************************************************ */
+void h2_cpu_pol_init (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Set up the CPU policers from the flash configuration.
+ * Remarks     : The CPU ports are also set to serve their queues round
+ *               robin, so the queue taking broadcast and learn frames cannot
+ *               starve the BPDU and LLDP queues.
+ * Restrictions: Call after flash_load_config().
+ * See also    : h2_cpu_pol_set()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar pol;
+
+    H2_WRITE(VTSS_ANA_ANA_STORMLIMIT_BURST,
+             VTSS_F_ANA_ANA_STORMLIMIT_BURST_STORM_BURST(CPU_POL_BURST));
+    for (pol = 0; pol < CPU_POL_CNT; pol++) {
+        cpu_pol_rate[pol] = flash_read_cpu_pol(pol);
+        if (cpu_pol_rate[pol] != CPU_POL_DISABLED &&
+            (cpu_pol_rate[pol] & ~(CPU_POL_KILO | 0xf))) {
+            /* CPU_POL_DEFAULT, or not saved by this firmware */
+            cpu_pol_rate[pol] = cpu_pol_encode(cpu_pol_default_fps[pol]);
+        }
+        cpu_pol_apply(pol);
+    }
+
+    H2_WRITE_MASKED(VTSS_SYS_SCH_SCH_CPU, VTSS_F_SYS_SCH_SCH_CPU_SCH_CPU_RR(3),
+                    VTSS_M_SYS_SCH_SCH_CPU_SCH_CPU_RR);
+    H2_WRITE(VTSS_ANA_ANA_ANEVENTS, VTSS_F_ANA_ANA_ANEVENTS_STORM_DROP);
+    cpu_pol_drop_sec = 0;
+}
+
+/* ************************************************************************ */
+void h2_cpu_pol_set (const uchar pol, const ulong fps)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Set the rate of a CPU policer.
+ * Remarks     : fps is rounded down to a power of two, 0 disables the
+ *               policer. The flash copy is updated by "CONFIG SAVE".
+ * Restrictions:
+ * See also    : h2_cpu_pol_get()
+ * Example     :
+ ****************************************************************************/
+{
+    if (pol >= CPU_POL_CNT) {
+        return;
+    }
+    cpu_pol_rate[pol] = cpu_pol_encode(fps);
+#if LUTON_UNMANAGED_CONF_IF
+    flash_write_cpu_pol(pol, cpu_pol_rate[pol]);
+#endif
+    cpu_pol_apply(pol);
+}
+
+/* ************************************************************************ */
+ulong h2_cpu_pol_get (const uchar pol)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Get the rate of a CPU policer in frames/s, 0 if disabled.
+ * Remarks     :
+ * Restrictions:
+ * See also    : h2_cpu_pol_set()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar rate = cpu_pol_rate[pol];
+
+    if (rate & CPU_POL_DISABLED) {
+        return 0;
+    }
+    return ((rate & CPU_POL_KILO) ? 1000UL : 1UL) << (rate & 0xf);
+}
+
+/* ************************************************************************ */
+void h2_cpu_pol_1sec (void)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Count the seconds in which the CPU policers dropped frames.
+ * Remarks     : The hardware only has a sticky bit for storm drops, so this
+ *               is the best resolution available.
+ * Restrictions: Call once a second.
+ * See also    : h2_cpu_pol_drop_get()
+ * Example     :
+ ****************************************************************************/
+{
+    ulong events;
+
+    H2_READ(VTSS_ANA_ANA_ANEVENTS, events);
+    if (events & VTSS_F_ANA_ANA_ANEVENTS_STORM_DROP) {
+        H2_WRITE(VTSS_ANA_ANA_ANEVENTS, VTSS_F_ANA_ANA_ANEVENTS_STORM_DROP);
+        cpu_pol_drop_sec++;
+    }
+}
+
+ulong h2_cpu_pol_drop_get (void)
+{
+    return cpu_pol_drop_sec;
+}
+
+void h2_cpu_pol_drop_clear (void)
+{
+    cpu_pol_drop_sec = 0;
+}
+#endif /* TRANSIT_CPU_POLICING */
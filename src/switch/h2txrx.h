@@ -16,7 +16,35 @@ extern uchar xdata rx_packet[];
 void   h2_bpdu_t_registration (uchar type, uchar enable);
 void   h2_rx_conf_set(void);
 void   h2_rx_flush (void) small;
-void   h2_send_frame (uchar port_no, uchar xdata *frame_ptr, ushort frame_len);
+
+/* Receive ring statistics, see RX_RING_CNT */
+uchar  h2_rx_ring_hwm_get (void);
+ulong  h2_rx_ring_stall_get (void);
+void   h2_rx_ring_stat_clear (void);
+#if USE_XTR_IRQ
+void   h2_rx_interrupt (ulong ident) small;
+#endif
+
+#if TRANSIT_CPU_POLICING
+/* CPU policers, in the order of the storm policers in ANA:ANA:STORMLIMIT_CFG */
+#define CPU_POL_UC          0   /* Flooded unicast */
+#define CPU_POL_BC          1   /* Broadcast */
+#define CPU_POL_MC          2   /* Flooded multicast */
+#define CPU_POL_LEARN       3   /* Learn frames */
+#define CPU_POL_CNT         4
+
+/* Encoded rate: 2^n frames/s in bits 0-3, kiloframes/s if CPU_POL_KILO */
+#define CPU_POL_KILO        0x10
+#define CPU_POL_DISABLED    0x80
+#define CPU_POL_DEFAULT     0xff    /* Use CPU_POL_xx_FPS of swconf.h */
+
+void   h2_cpu_pol_init (void);
+void   h2_cpu_pol_set (const uchar pol, const ulong fps);
+ulong  h2_cpu_pol_get (const uchar pol);
+void   h2_cpu_pol_1sec (void);
+ulong  h2_cpu_pol_drop_get (void);
+void   h2_cpu_pol_drop_clear (void);
+#endif
 
 #endif
 
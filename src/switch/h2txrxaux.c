@@ -14,6 +14,9 @@
 #include "hwport.h"
 #include <string.h>
 #include "spiflash.h"
+#if USE_FDMA_XTR || USE_FDMA_INJ
+#include "h2fdma.h"
+#endif
 #if TRANSIT_LOOPDETECT
 #include "loopdet.h"
 #endif
@@ -27,44 +30,131 @@
 #define XTR_ESCAPE    0x80000006UL
 #define XTR_NOT_READY 0x80000007UL
 
+/*
+ * Frames to keep once the header has been peeked at, everything else is
+ * drained from the queue without being stored.
+ */
+#if LOOPBACK_TEST
+#define RX_CLASS_WANTED(cls) TRUE   /* txrxtst.c compares whole frames */
+#elif TRANSIT_LLDP && TRANSIT_IGMP_SNOOP
+#define RX_CLASS_WANTED(cls) ((cls) == RX_CLASS_LLDP || (cls) == RX_CLASS_IPMC)
+#elif TRANSIT_LLDP
+#define RX_CLASS_WANTED(cls) ((cls) == RX_CLASS_LLDP)
+#else
+#define RX_CLASS_WANTED(cls) FALSE
+#endif
+
+/* IFH CPU queue mask of the frames redirected by CPU_IGMP_REDIR_ENA */
+#define RX_IGMP_QU_MASK (1 << (PACKET_XTR_QU_IGMP - VTSS_PACKET_RX_QUEUE_START))
 
+/* Frames seen per class, frames aborted or too long for rx_packet, and
+   frames cut short by XTR_FRM_PRUNING. Also the original length of the
+   longest frame too long for rx_packet */
+static ulong xdata rx_class_cnt [RX_CLASS_CNT];
+static ulong xdata rx_err_cnt;
+static ulong xdata rx_pruned_cnt;
+static ushort xdata rx_long_max;
 
 static ulong rx_word (uchar qno);
 static void  tx_word (uchar qno, ulong value);
 static bool  fifo_status(uchar qno);
+static uchar tx_frame_start (const uchar port_no);
+static void  tx_frame_end (const uchar qno, ushort w, const uchar vld);
 
-static void h2_rx_frame_discard(const uchar qno)
+/* Drop the rest of a frame, returns the number of bytes dropped */
+static ushort h2_rx_frame_discard(const uchar qno)
 {
-    uchar done = FALSE;
+    uchar  done = FALSE;
+    ushort bytes = 0;
 
     while(!done) {
         ulong val;
         val = rx_word(qno);
         switch(val) {
-        case XTR_ABORT:
         case XTR_PRUNED:
+            rx_pruned_cnt++;
+            /* FALLTHROUGH */
         case XTR_EOF_3:
         case XTR_EOF_2:
         case XTR_EOF_1:
         case XTR_EOF_0:
+            bytes += (val == XTR_PRUNED) ? 4 : 4 - (uchar) (val - XTR_EOF_0);
+            /* FALLTHROUGH */
+        case XTR_ABORT:
             val = rx_word(qno); /* Last data */
             done = TRUE;        /* Last 1-4 bytes */
             break;
         case XTR_ESCAPE:
             val = rx_word(qno); /* Escaped data */
+            bytes += 4;
             break;
         case XTR_NOT_READY:
+            break;
         default:
-            ;
+            bytes += 4;
+        }
+    }
+    return bytes;
+}
+
+static uchar rx_frame_classify(vtss_rx_frame_t xdata * rx_frame_ptr, mac_addr_t self_mac_addr)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Classify a frame from its IFH and first 16 bytes.
+ * Remarks     : Also reports frames sent by ourselves to the loop detection.
+ *               IGMP is redirected to the CPU, which must forward it, so
+ *               it is RX_CLASS_IPMC whatever its DMAC and SMAC.
+ * Restrictions: IFH, DMAC, SMAC and EtherType must be in rx_frame_ptr.
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    vtss_eth_hdr xdata * eth_hdr = rx_frame_ptr->rx_packet;
+    uchar self;
+
+    self = (mac_cmp(eth_hdr->src.addr, self_mac_addr) == 0);
+    if(self) {
+#if TRANSIT_LOOPDETECT
+#if LOOPBACK_TEST
+        if (eth_hdr->type != 0x8809)
+#endif
+            ldet_add_cpu_found(rx_frame_ptr->header.port);  //Local loop was found on port
+#endif
+    }
+
+#if TRANSIT_IGMP_SNOOP
+    if(rx_frame_ptr->header.cpuq & RX_IGMP_QU_MASK) {
+        return RX_CLASS_IPMC;
+    }
+#endif
+
+    if((eth_hdr->dest.addr[0] == 0x01) &&
+            (eth_hdr->dest.addr[1] == 0x80) &&
+            (eth_hdr->dest.addr[2] == 0xc2) &&
+            (eth_hdr->dest.addr[3] == 0x00) &&
+            (eth_hdr->dest.addr[4] == 0x00)) {
+        if(eth_hdr->dest.addr[5] == 0x0e && eth_hdr->type == HTONS(VTSS_ETHTYPE_LLDP)) {
+            return RX_CLASS_LLDP;
         }
+        return self ? RX_CLASS_SELF : RX_CLASS_BPDU;
     }
+
+    if((eth_hdr->dest.addr[0] == 0x01) &&
+            (eth_hdr->dest.addr[1] == 0x00) &&
+            (eth_hdr->dest.addr[2] == 0x5e)) {
+        /* IGMP, or IPv4 multicast flooded to the CPU */
+        return self ? RX_CLASS_SELF : RX_CLASS_IPMC;
+    }
+
+    return self ? RX_CLASS_SELF : RX_CLASS_OTHER;
 }
 
-void h2_rx_frame_get (const uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr)
+bool h2_rx_frame_get (const uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr)
 /* ------------------------------------------------------------------------ --
  * Purpose     : Receive frame.
  * Remarks     : The structure pointed to by rx_frame_ptr is updated with the
  *               data received, see h2packet.h for a description of the structure.
+ *               Returns TRUE if a frame was taken from the group, even if it
+ *               was then discarded, and FALSE if the group was empty.
  * Restrictions: Only to be called if h2_frame_received has returned TRUE.
  * See also    :
  * Example     :
@@ -74,16 +164,44 @@ void h2_rx_frame_get (const uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr)
     ulong  ifh0, ifh1;
     ulong  xdata *packet;
     uchar  eof_flag, escape_flag, abort_flag, pruned_flag;
+    uchar  cls;
 
 #define MAX_LENGTH (RECV_BUFSIZE+2)
 
-    vtss_eth_hdr xdata * eth_hdr = rx_frame_ptr->rx_packet;
     mac_addr_t self_mac_addr;
 
     get_mac_addr(SYSTEM_MAC_ADDR, self_mac_addr);
 
     h2_discard_frame(rx_frame_ptr);
 
+#if USE_FDMA_XTR
+    if(h2_fdma_xtr_active()) {
+        switch(h2_fdma_xtr_get(qno, rx_frame_ptr)) {
+        case FDMA_XTR_FRAME:
+            cls = rx_frame_classify(rx_frame_ptr, self_mac_addr);
+            rx_class_cnt[cls]++;
+            if(rx_frame_ptr->pruned) {
+                rx_pruned_cnt++;
+            }
+            if(RX_CLASS_WANTED(cls) && !rx_frame_ptr->pruned) {
+                rx_frame_ptr->discard = 0;
+                h2_fdma_xtr_done(qno, rx_frame_ptr);
+            } else {
+                h2_fdma_xtr_done(qno, rx_frame_ptr);
+                h2_discard_frame(rx_frame_ptr);
+            }
+            break;
+        case FDMA_XTR_ERROR:
+            rx_err_cnt++;
+            h2_discard_frame(rx_frame_ptr);
+            break;
+        default:
+            return FALSE;
+        }
+        return TRUE;
+    }
+#endif
+
     H2_READ(VTSS_DEVCPU_QS_XTR_XTR_DATA_PRESENT, qstat);
 
     if(test_bit_32(qno, &qstat)) {
@@ -93,6 +211,7 @@ void h2_rx_frame_get (const uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr)
         memset(&rx_frame_ptr->header, 0, sizeof(vtss_packet_rx_header_t));
         rx_frame_ptr->header.port = IFH_GET(ifh0, ifh1, PORT);
         rx_frame_ptr->header.vid  = IFH_GET(ifh0, ifh1, VID);
+        rx_frame_ptr->header.cpuq = IFH_GET(ifh0, ifh1, CPUQ);
 
         packet = (ulong *) rx_frame_ptr->rx_packet;
 
@@ -137,53 +256,87 @@ void h2_rx_frame_get (const uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr)
                 /* FALLTHROUGH */
             default:
                 if(rx_frame_ptr->total_bytes == 12) {
-
-                    if((eth_hdr->dest.addr[0] == 0x01) &&
-                            (eth_hdr->dest.addr[1] == 0x80) &&
-                            (eth_hdr->dest.addr[2] == 0xc2) &&
-                            (eth_hdr->dest.addr[3] == 0x00) &&
-                            (eth_hdr->dest.addr[4] == 0x00)) {
-#if TRANSIT_LLDP
-                        if(eth_hdr->dest.addr[5] != 0x0e) { // LLDP frame
+                    /* The first 16 bytes are in: drop unwanted frames
+                       before the rest is copied */
+                    cls = rx_frame_classify(rx_frame_ptr, self_mac_addr);
+                    rx_class_cnt[cls]++;
+                    if(!RX_CLASS_WANTED(cls)) {
+                        if(!eof_flag) {
                             h2_rx_frame_discard(qno);
-                            abort_flag = 1;
-                            goto discard_packet;
                         }
-#endif
+                        abort_flag = 1;
+                        goto discard_packet;
                     }
-
-                    if(mac_cmp(eth_hdr->src.addr, self_mac_addr) == 0) {
-#if TRANSIT_LOOPDETECT
-#if LOOPBACK_TEST
-                        if (eth_hdr->type != 0x8809)
-#endif
-                            ldet_add_cpu_found(rx_frame_ptr->header.port);  //Local loop was found on port
-#endif
-                    }
-
-
                 }
                 rx_frame_ptr->total_bytes += 4;
                 packet++;
+
+                if(!eof_flag && rx_frame_ptr->total_bytes + 4 > MAX_LENGTH) {
+                    /* No room for the next word, e.g. a jumbo frame. It is
+                       read to the end anyway, so keep its length */
+                    rx_frame_ptr->total_bytes += h2_rx_frame_discard(qno);
+                    if(rx_frame_ptr->total_bytes > rx_long_max) {
+                        rx_long_max = rx_frame_ptr->total_bytes;
+                    }
+                    rx_err_cnt++;
+                    abort_flag = 1;
+                    goto discard_packet;
+                }
             }
         }
 
+        if(abort_flag) {
+            rx_err_cnt++;
+        }
+
         if(eof_flag) {
             rx_frame_ptr->discard = 0;
         }
 
         if(pruned_flag) {
+            /* The tail is missing, so the frame cannot be parsed */
+            rx_pruned_cnt++;
+            h2_discard_frame(rx_frame_ptr);
             rx_frame_ptr->pruned = 1;
+            return TRUE;
         }
 
 discard_packet:
         if(abort_flag || !eof_flag) {
             h2_discard_frame(rx_frame_ptr);
-            return;
         }
+        return TRUE;
     }
+    return FALSE;
 }
 
+#if LOOPBACK_TEST
+bool h2_rx_frame_drop (const uchar qno)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Drop the next frame of a group without looking at it.
+ * Remarks     : Returns FALSE if the group was empty.
+ * Restrictions:
+ * See also    : h2_rx_frame_get()
+ * Example     :
+ ****************************************************************************/
+{
+    ulong qstat;
+
+#if USE_FDMA_XTR
+    if(h2_fdma_xtr_active()) {
+        return h2_fdma_xtr_skip(qno);
+    }
+#endif
+
+    H2_READ(VTSS_DEVCPU_QS_XTR_XTR_DATA_PRESENT, qstat);
+    if(!test_bit_32(qno, &qstat)) {
+        return FALSE;
+    }
+    h2_rx_frame_discard(qno);
+    return TRUE;
+}
+#endif /* LOOPBACK_TEST */
+
 bool h2_tx_frame_port(const uchar port_no,
                       const uchar *const frame,
                       const ushort length,
@@ -193,45 +346,27 @@ bool h2_tx_frame_port(const uchar port_no,
  * Remarks     : port_no specifies the Heathrow transmit port.
  *               frame_ptr points to the frame data and frame_len specifies
  *               the length of frame data in number of bytes.
+ *               With USE_FDMA_INJ, frames that h2_fdma_inj_usable() accepts
+ *               are queued to the FDMA and may still be in flight on return.
  * Restrictions:
  * See also    :
  * Example     :
  ****************************************************************************/
 {
-    ulong ifh0 = 0, ifh1 = 0;
-    port_bit_mask_t  dest_port_mask = 0;
-    vtss_vid_t tx_vid = vid;
-
     const ulong *bufptr = (ulong *) frame;
     ulong        buflen = length, count, w, last, val;
 
     uchar qno;
 
-#if 0
-    WRITE_PORT_BIT_MASK(port_no, 1, &dest_port_mask);
-
-    /* Calculate and send IFH0 and IFH1 */
-    /* In order for IFH-DEST-field, then set the BYPASS. */
-    IFH_PUT(ifh0, ifh1, BYPASS, 1);
-    IFH_PUT(ifh0, ifh1, DEST, dest_port_mask);
+#if USE_FDMA_INJ
+    if(h2_fdma_inj_usable((const uchar xdata *) frame, length)) {
+        return h2_fdma_inj_frame(port_no, (const uchar xdata *) frame, length, vid) != 0;
+    }
 #endif
 
-    ifh0 = VTSS_ENCODE_BITFIELD(1, 63 - 32, 1) | /* BYPASS */
-           VTSS_ENCODE_BITFIELD(1, port_no, 1);  /* DEST */
-
-    ifh1 = VTSS_ENCODE_BITFIELD(3, 28, 2); /* POP_CNT=3 disables rewriter */
-
-    /* Select a tx queue */
-    for(qno = VTSS_PACKET_TX_QUEUE_START; qno < VTSS_PACKET_TX_QUEUE_END; qno++) {
-        if(fifo_status(qno))
-            break;
-    }
+    qno = tx_frame_start(port_no);
     if(qno == VTSS_PACKET_TX_QUEUE_END) return FALSE; // No tx queue available.
 
-    H2_WRITE(VTSS_DEVCPU_QS_INJ_INJ_CTRL(qno), VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_SOF);
-    tx_word(qno, ifh0);
-    tx_word(qno, ifh1);
-
     count = buflen / 4;
     last  = buflen % 4;
 
@@ -256,23 +391,111 @@ bool h2_tx_frame_port(const uchar port_no,
         w++;
     }
 
-    /* Add padding */
-    while (w < 15 /*(60/4)*/ ) {
-        tx_word(qno, 0);
-        w++;
+    tx_frame_end(qno, w, length < 60 ? 0 : last);
+
+    return TRUE;
+}
+
+bool h2_tx_frame_sg(const uchar port_no,
+                    const vtss_tx_frag_t *frags,
+                    uchar frag_cnt,
+                    const vtss_vid_t vid)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Send a frame made of frag_cnt fragments on the specified port.
+ * Remarks     : The fragments are written to the injection FIFO in turn,
+ *               without being copied together first, and may be cut at any
+ *               byte. Unless vid is VTSS_VID_NULL a C-tag is inserted after
+ *               the first 12 bytes, whichever fragment they are in.
+ *               A single fragment is passed on to h2_tx_frame_port(), so it
+ *               may still go by FDMA.
+ * Restrictions: The fragments are only read during the call.
+ * See also    : h2_tx_frame_port()
+ * Example     : Send a per-port header and a shared body:
+ *               frags[0].buf = hdr;  frags[0].len = 14;
+ *               frags[1].buf = body; frags[1].len = body_len;
+ *               h2_tx_frame_sg(port_no, frags, 2, VTSS_VID_NULL);
+ ****************************************************************************/
+{
+    union {
+        ulong l;
+        uchar b[4];     /* b[0] goes first on the wire */
+    } val;
+    const uchar *src;
+    ushort len;
+    ushort cnt = 0;     /* Bytes written, incl. C-tag */
+    uchar  b = 0;       /* Bytes collected in val */
+    uchar  qno;
+
+    if(frag_cnt == 1) {
+        return h2_tx_frame_port(port_no, frags->buf, frags->len, vid);
     }
 
-    /* Indicate EOF and valid bytes in last word */
-    H2_WRITE(VTSS_DEVCPU_QS_INJ_INJ_CTRL(qno),
-             VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_VLD_BYTES(length < 60 ? 0 : last) |
-             VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_EOF);
+    qno = tx_frame_start(port_no);
+    if(qno == VTSS_PACKET_TX_QUEUE_END) return FALSE; // No tx queue available.
 
-    /* Add dummy CRC */
-    tx_word(qno, 0);
+    for(; frag_cnt; frag_cnt--, frags++) {
+        src = frags->buf;
+        len = frags->len;
+        while(len) {
+            if(b == 0) {
+                if(cnt == 12 && vid != VTSS_VID_NULL) {
+                    /* Insert C-tag, always at a word boundary */
+                    tx_word(qno, ushorts2ulong(0x8100, vid));
+                    cnt += 4;
+                }
+                if(len >= 4) {
+                    tx_word(qno, *(const ulong *) src);
+                    src += 4;
+                    len -= 4;
+                    cnt += 4;
+                    continue;
+                }
+            }
+            /* Fragment ends within a word, carry it on to the next one */
+            val.b[b++] = *src++;
+            len--;
+            cnt++;
+            if(b == 4) {
+                tx_word(qno, val.l);
+                b = 0;
+            }
+        }
+    }
+
+    if(b) {
+        while(b < 4) {
+            val.b[b++] = 0;
+        }
+        tx_word(qno, val.l);
+    }
+
+    tx_frame_end(qno, (cnt + 3) / 4, cnt < 60 ? 0 : cnt % 4);
 
     return TRUE;
 }
 
+ulong h2_rx_class_cnt_get(const uchar cls)
+{
+    if(cls == RX_CLASS_CNT) {
+        return rx_err_cnt;
+    }
+    if(cls == RX_CLASS_CNT + 1) {
+        return rx_pruned_cnt;
+    }
+    if(cls == RX_CLASS_CNT + 2) {
+        return rx_long_max;
+    }
+    return rx_class_cnt[cls];
+}
+
+void h2_rx_class_cnt_clear(void)
+{
+    memset(rx_class_cnt, 0, sizeof(rx_class_cnt));
+    rx_err_cnt = 0;
+    rx_pruned_cnt = 0;
+    rx_long_max = 0;
+}
+
 void h2_discard_frame( vtss_rx_frame_t xdata * rx_frame_ptr)
 {
     rx_frame_ptr->total_bytes = 0;
@@ -280,6 +503,78 @@ void h2_discard_frame( vtss_rx_frame_t xdata * rx_frame_ptr)
     rx_frame_ptr->pruned = 0;
 }
 
+static uchar tx_frame_start (const uchar port_no)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Select a register based injection group and write the IFH
+ *               of a frame to port_no.
+ * Remarks     : Returns the group, or VTSS_PACKET_TX_QUEUE_END if none is
+ *               ready.
+ * Restrictions:
+ * See also    : tx_frame_end()
+ * Example     :
+ ****************************************************************************/
+{
+    ulong ifh0 = 0, ifh1 = 0;
+    uchar qno;
+
+#if 0
+    port_bit_mask_t  dest_port_mask = 0;
+
+    WRITE_PORT_BIT_MASK(port_no, 1, &dest_port_mask);
+
+    /* Calculate and send IFH0 and IFH1 */
+    /* In order for IFH-DEST-field, then set the BYPASS. */
+    IFH_PUT(ifh0, ifh1, BYPASS, 1);
+    IFH_PUT(ifh0, ifh1, DEST, dest_port_mask);
+#endif
+
+    ifh0 = VTSS_ENCODE_BITFIELD(1, 63 - 32, 1) | /* BYPASS */
+           VTSS_ENCODE_BITFIELD(1, port_no, 1);  /* DEST */
+
+    ifh1 = VTSS_ENCODE_BITFIELD(3, 28, 2); /* POP_CNT=3 disables rewriter */
+
+    /* Select a tx queue */
+    for(qno = VTSS_PACKET_TX_QUEUE_START; qno < VTSS_PACKET_TX_QUEUE_END; qno++) {
+#if USE_FDMA_INJ
+        if(qno == FDMA_INJ_GRP && h2_fdma_inj_active())
+            continue;   // Owned by the FDMA
+#endif
+        if(fifo_status(qno))
+            break;
+    }
+    if(qno == VTSS_PACKET_TX_QUEUE_END) return qno;
+
+    H2_WRITE(VTSS_DEVCPU_QS_INJ_INJ_CTRL(qno), VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_SOF);
+    tx_word(qno, ifh0);
+    tx_word(qno, ifh1);
+
+    return qno;
+}
+
+static void tx_frame_end (const uchar qno, ushort w, const uchar vld)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Pad a frame of w words to 60 bytes and finish it.
+ * Remarks     : vld is the number of valid bytes in the last word, 0 for 4.
+ * Restrictions:
+ * See also    : tx_frame_start()
+ * Example     :
+ ****************************************************************************/
+{
+    /* Add padding */
+    while (w < 15 /*(60/4)*/ ) {
+        tx_word(qno, 0);
+        w++;
+    }
+
+    /* Indicate EOF and valid bytes in last word */
+    H2_WRITE(VTSS_DEVCPU_QS_INJ_INJ_CTRL(qno),
+             VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_VLD_BYTES(vld) |
+             VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_EOF);
+
+    /* Add dummy CRC */
+    tx_word(qno, 0);
+}
+
 static void tx_word (uchar qno, ulong value)
 /* ------------------------------------------------------------------------ --
  * Purpose     : Write a 32-bit chunk to transmit fifo.
@@ -6,11 +6,33 @@
 
 #include "h2packet.h"
 
-extern void   h2_rx_frame_get (uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr);
+/* Classes of frames reaching the CPU, see h2_rx_class_cnt_get() */
+#define RX_CLASS_LLDP   0   /* LLDP frames */
+#define RX_CLASS_BPDU   1   /* Other 01-80-C2-00-00-xx frames */
+#define RX_CLASS_SELF   2   /* Sent by ourselves, i.e. looped back */
+#define RX_CLASS_IPMC   3   /* IGMP and other 01-00-5E-xx-xx-xx frames */
+#define RX_CLASS_OTHER  4   /* Anything else */
+#define RX_CLASS_CNT    5
+
+extern bool   h2_rx_frame_get (uchar qno, vtss_rx_frame_t xdata * rx_frame_ptr);
+#if LOOPBACK_TEST
+extern bool   h2_rx_frame_drop (const uchar qno);
+#endif
 extern bool   h2_tx_frame_port(const uchar port_no,
                                const uchar *const frame,
                                const ushort length,
                                const vtss_vid_t vid);
+extern bool   h2_tx_frame_sg(const uchar port_no,
+                             const vtss_tx_frag_t *frags,
+                             uchar frag_cnt,
+                             const vtss_vid_t vid);
 extern void   h2_discard_frame( vtss_rx_frame_t xdata * rx_frame_ptr);
 
+/* Frames seen in a class, with cls RX_CLASS_CNT the aborted/too long ones and
+   with RX_CLASS_CNT + 1 the ones pruned by the extraction group. With
+   RX_CLASS_CNT + 2 the original length (incl. FCS) of the longest frame too
+   long for rx_packet; that of a pruned frame is not known */
+extern ulong  h2_rx_class_cnt_get(const uchar cls);
+extern void   h2_rx_class_cnt_clear(void);
+
 #endif
@@ -41,6 +41,10 @@
 #define pac_len_t uchar
 //#define pac_len_t ushort
 
+#define BENCH_HDR_LENGTH    18  /* DMAC, SMAC, type, subtype and OUI */
+#define BENCH_WINDOW        4   /* Frames injected ahead of extraction */
+#define BENCH_IDLE_MSEC     200 /* Frames in flight this long are lost */
+
 /*****************************************************************************
  *
  *
@@ -60,6 +64,8 @@
  ****************************************************************************/
 
 static uchar test_tx_rx (uchar rx_port_no, uchar tx_port_no);
+static void  cpu_capture (uchar rx_port_no, uchar enable);
+static void  build_packet (uchar port_no);
 static void  send_packet (uchar port_no);
 static uchar get_and_check_packet (uchar rx_port_no);
 static void  init_port (uchar port_no, uchar mode);
@@ -350,6 +356,154 @@ void perform_tx_rx_test (uchar port_no, uchar speed, uchar external_loopback)
 
 }
 
+static ulong access_cnt_get (void)
+{
+    ulong cnt;
+
+    EA = 0;
+    cnt = h2_access_cnt;
+    EA = 1;
+    return cnt;
+}
+
+/* ************************************************************************ */
+void perform_tx_rx_bench (uchar port_no, ushort length, ushort count)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Measure CPU injection and extraction throughput on a port in
+ *               internal PHY loopback. Dump results to RS-232.
+ * Remarks     : count frames of length bytes (incl. CRC) are injected through
+ *               h2_tx_frame_port() with at most BENCH_WINDOW in flight, and
+ *               extracted through h2_rx_frame_get(), once for each extraction
+ *               group. For each group frames/s, bytes/s and the register
+ *               accesses per frame on tx and rx (incl. empty polls) are shown.
+ *               Frames not back within BENCH_IDLE_MSEC are counted as lost.
+ * Restrictions: length must be in range BENCH_LENGTH_MIN-BENCH_LENGTH_MAX, as
+ *               frames are built in rx_packet. The port must have a PHY.
+ * See also    : perform_tx_rx_test()
+ * Example     :
+ ****************************************************************************/
+{
+    uchar  port;
+    uchar  grp;
+    uchar  xdata *frame;
+    ushort sent;
+    ushort rcvd;
+    ushort lost;
+    ulong  sch_cpu;
+    ulong  qu_flush;
+    ulong  start;
+    ulong  idle;
+    ulong  msec;
+    ulong  tx_ops;
+    ulong  rx_ops;
+    ulong  ops;
+
+    port = port2int(port_no);
+    if (!phy_map(port)) {
+        return;
+    }
+
+    phy_set_forced_speed(port, LINK_MODE_SPEED_1000 | LINK_MODE_FDX_MASK | LINK_MODE_INT_LOOPBACK);
+    start_timer(MSEC_2000);
+    while (!phy_link_status(port)) {
+        if (timeout()) {
+            phy_restart(port);
+            return;
+        }
+        delay_1(2);
+    }
+    init_port(port, LINK_MODE_SPEED_1000 | LINK_MODE_FDX_MASK);
+    delay(MSEC_50);
+
+    H2_READ(VTSS_SYS_SCH_SCH_CPU, sch_cpu);
+    H2_READ(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, qu_flush);
+    cpu_capture(port, TRUE);
+    H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, 0);
+
+    /* Frames are sent from rx_packet; when extracted by registers they are
+       copied back on top of themselves, so only the header is refreshed */
+    frame = vtss_rx_frame.rx_packet;
+    build_packet(port_no);
+
+    print_str("\r\nGrp  Frames  Lost   msec  Frames/s   Bytes/s  Tx ops  Rx ops\r\n");
+    for (grp = 0; grp < VTSS_PACKET_RX_GROUP_CNT; grp++) {
+        /* Send all CPU queues to the group under test */
+        H2_WRITE_MASKED(VTSS_SYS_SCH_SCH_CPU,
+                        grp ? VTSS_M_SYS_SCH_SCH_CPU_SCH_CPU_MAP : 0,
+                        VTSS_M_SYS_SCH_SCH_CPU_SCH_CPU_MAP);
+
+        sent   = 0;
+        rcvd   = 0;
+        lost   = 0;
+        tx_ops = 0;
+        rx_ops = 0;
+        start  = ms_ticks_get();
+        idle   = start;
+        while ((ushort) (rcvd + lost) < count) {
+            if (sent < count && (ushort) (sent - rcvd - lost) < BENCH_WINDOW) {
+                memcpy(frame, tx_buf, BENCH_HDR_LENGTH);
+                ops = access_cnt_get();
+                if (h2_tx_frame_port(port, frame, length - 4, VTSS_VID_NULL)) {
+                    sent++;
+                }
+                tx_ops += access_cnt_get() - ops;
+            }
+
+            vtss_rx_frame.rx_packet = frame;
+            ops = access_cnt_get();
+            if (h2_rx_frame_get(grp, &vtss_rx_frame)) {
+                if (vtss_rx_frame.header.port == port) {
+                    /* A frame dropped on extraction is lost, not received */
+                    if (vtss_rx_frame.discard) {
+                        lost++;
+                    } else {
+                        rcvd++;
+                    }
+                    idle = ms_ticks_get();
+                }
+            } else if (ms_ticks_get() - idle > BENCH_IDLE_MSEC) {
+                if (sent == (ushort) (rcvd + lost)) {
+                    break; /* Nothing in flight, injection is stuck */
+                }
+                lost = sent - rcvd;
+                idle = ms_ticks_get();
+            }
+            rx_ops += access_cnt_get() - ops;
+        }
+        msec = ms_ticks_get() - start;
+        if (msec == 0) {
+            msec = 1;
+        }
+
+        print_str("  ");
+        print_dec(grp);
+        print_dec_nright(rcvd, 8);
+        print_dec_nright(lost, 6);
+        print_dec_nright(msec, 7);
+        print_dec_nright((rcvd * 1000UL) / msec, 10);
+        print_dec_nright(((rcvd * 1000UL) / msec) * length, 10);
+        print_dec_nright(sent ? tx_ops / sent : 0, 8);
+        print_dec_nright(rcvd ? rx_ops / rcvd : 0, 8);
+        print_cr_lf();
+    }
+    vtss_rx_frame.rx_packet = frame;
+
+    /* Drain frames that came back after being counted as lost */
+    delay(MSEC_20);
+    for (grp = 0; grp < VTSS_PACKET_RX_GROUP_CNT; grp++) {
+        while (h2_rx_frame_drop(grp)) {
+        }
+    }
+
+    cpu_capture(port, FALSE);
+    H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, qu_flush);
+    H2_WRITE(VTSS_SYS_SCH_SCH_CPU, sch_cpu);
+
+    phy_restart(port);
+
+    print_str(txt_14); /* completed message */
+}
+
 static void init_port (uchar port_no, uchar mode)
 {
     /* Set MAC port in specific link speed and duplex. */
@@ -379,28 +533,10 @@ static uchar test_tx_rx (uchar rx_port_no, uchar tx_port_no)
     uchar recv_q = 0;
     ulong captured = 0;
     uchar timeout;
-#if !TRANSIT_BPDU_PASS_THROUGH
-    uchar l2_type;
-#endif
 
 
     /* Set analyzer to copy frame to CPU capture buffer */
-
-#if !TRANSIT_BPDU_PASS_THROUGH
-    for(l2_type = 0; l2_type < 0x10; l2_type++)
-        h2_bpdu_t_registration(l2_type, FALSE);
-#endif
-#if TRANSIT_LLDP
-#if TRANSIT_BPDU_PASS_THROUGH
-    if(lldp_os_get_admin_status(rx_port_no) == LLDP_ENABLED_RX_TX) {
-        h2_bpdu_t_registration(0x0E, FALSE);
-    }
-#else
-    h2_bpdu_t_registration(0x0E, FALSE);
-#endif
-#endif
-    h2_bpdu_t_registration(0x0E, TRUE); // Capture LLDP MAC address frame
-    H2_WRITE_MASKED(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, 0x0, 0x2);
+    cpu_capture(rx_port_no, TRUE);
 
     delay(MSEC_20);
 
@@ -429,6 +565,46 @@ static uchar test_tx_rx (uchar rx_port_no, uchar tx_port_no)
 
 
     /* Set analyzer to not copy frame to CPU capture buffer */
+    cpu_capture(rx_port_no, FALSE);
+
+
+    return result;
+}
+
+/* ************************************************************************ */
+static void cpu_capture (uchar rx_port_no, uchar enable)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Copy frames to the slow protocol address to the CPU, or
+ *               restore the normal BPDU registrations.
+ * Remarks     : All other BPDUs are kept away from the CPU while capturing.
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+#if !TRANSIT_BPDU_PASS_THROUGH
+    uchar l2_type;
+#endif
+
+    if (enable) {
+#if !TRANSIT_BPDU_PASS_THROUGH
+        for(l2_type = 0; l2_type < 0x10; l2_type++)
+            h2_bpdu_t_registration(l2_type, FALSE);
+#endif
+#if TRANSIT_LLDP
+#if TRANSIT_BPDU_PASS_THROUGH
+        if(lldp_os_get_admin_status(rx_port_no) == LLDP_ENABLED_RX_TX) {
+            h2_bpdu_t_registration(0x0E, FALSE);
+        }
+#else
+        h2_bpdu_t_registration(0x0E, FALSE);
+#endif
+#endif
+        h2_bpdu_t_registration(0x0E, TRUE); // Capture LLDP MAC address frame
+        H2_WRITE_MASKED(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, 0x0, 0x2);
+        return;
+    }
+
     h2_bpdu_t_registration(0x0E, FALSE);
 
     H2_WRITE_MASKED(VTSS_DEVCPU_QS_XTR_XTR_QU_FLUSH, 0x2, 0x2);
@@ -446,24 +622,18 @@ static uchar test_tx_rx (uchar rx_port_no, uchar tx_port_no)
     h2_bpdu_t_registration(0x0E, TRUE);
 #endif
 #endif
-
-
-    return result;
 }
 
 /* ************************************************************************ */
-static void send_packet (uchar port_no)
+static void build_packet (uchar port_no)
 /* ------------------------------------------------------------------------ --
- * Purpose     : Send packet.
+ * Purpose     : Build the test packet in tx_buf.
  * Remarks     :
  * Restrictions:
  * See also    :
  * Example     :
  ****************************************************************************/
 {
-    uchar ret = FALSE;
-
-
     /* See packet definition in AS0036 */
 
     /* Set the destination MAC Address to slow protocol multicast address */
@@ -492,6 +662,21 @@ static void send_packet (uchar port_no)
     tx_buf[26] = 'd';
     tx_buf[27] = '=';
     tx_buf[28] = '\0';
+}
+
+/* ************************************************************************ */
+static void send_packet (uchar port_no)
+/* ------------------------------------------------------------------------ --
+ * Purpose     : Send packet.
+ * Remarks     :
+ * Restrictions:
+ * See also    :
+ * Example     :
+ ****************************************************************************/
+{
+    uchar ret = FALSE;
+
+    build_packet(port_no);
 
     ret = h2_tx_frame_port(port_no, tx_buf, (PACKET_LENGTH - 4), VTSS_VID_NULL);
     if(!ret) {
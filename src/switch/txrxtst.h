@@ -6,6 +6,12 @@
 #define __TXRXTST_H__
 
 
+/* Frame lengths accepted by perform_tx_rx_bench(), incl. CRC. Longer
+   frames do not fit rx_packet and are dropped by h2_rx_frame_get() */
+#define BENCH_LENGTH_MIN    64
+#define BENCH_LENGTH_MAX    RECV_BUFSIZE
+
 void perform_tx_rx_test (uchar port_no, uchar speed, uchar external_loopback);
+void perform_tx_rx_bench (uchar port_no, ushort length, ushort count);
 
 #endif
@@ -0,0 +1,122 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+/*
+ * Host side calculator of the buffer profiles in src/switch/h2bufcfg.c.
+ * Prints the SYS:RES_CTRL:RES_CFG watermarks the firmware writes for a
+ * profile and a number of ports at each link speed, so a profile can be
+ * checked before it is selected with "CONFIG BUF n".
+ *
+ * Build on a PC, e.g. with gcc:
+ *   gcc -DBUFCALC_HOST -I../src/switch -o bufcalc bufcalc.c ../src/switch/h2bufcfg.c
+ *
+ * Usage:
+ *   bufcalc <profile> [down 10M 100M 1G 2.5G]
+ *
+ * The profile is its number or name. The port counts are the number of
+ * ports at each speed, the firmware counts the CPU port as 1G. Without
+ * counts all 27 ports are taken as 1G.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "h2bufcfg.h"
+
+static const char *res_txt [BUF_RES_CNT] = {
+    "BUF ingress", "REF ingress", "BUF egress", "REF egress"
+};
+
+static const char *speed_txt [BUF_SPEED_CNT] = {
+    "down", "10M", "100M", "1G", "2.5G"
+};
+
+/* Value of an encoded watermark, in units of 48 bytes or in frames */
+static ulong wm_decode (ushort wm)
+{
+    if (wm >= 1024) {
+        return (ulong) (wm - 1024) * 16;
+    }
+    return wm;
+}
+
+/* A watermark as written, and in bytes or frames */
+static void print_wm (uchar res, ushort wm)
+{
+    if (res == BUF_RES_BUF_I || res == BUF_RES_BUF_E) {
+        printf(" 0x%03x (%lu bytes)", wm, wm_decode(wm) * 48);
+    } else {
+        printf(" 0x%03x (%lu frames)", wm, wm_decode(wm));
+    }
+}
+
+int main (int argc, char **argv)
+{
+    buf_cfg_t cfg;
+    uchar     port_cnt [BUF_SPEED_CNT];
+    uchar     profile;
+    uchar     res;
+    uchar     i;
+    ushort    base;
+
+    if (argc != 2 && argc != 2 + BUF_SPEED_CNT) {
+        fprintf(stderr, "usage: %s <profile> [down 10M 100M 1G 2.5G]\n", argv[0]);
+        return 1;
+    }
+
+    for (profile = 0; profile < BUF_PROFILE_CNT; profile++) {
+        if (strcmp(argv[1], h2_buf_profile_name(profile)) == 0) {
+            break;
+        }
+    }
+    if (profile == BUF_PROFILE_CNT) {
+        profile = (uchar) strtoul(argv[1], NULL, 0);
+        if (profile >= BUF_PROFILE_CNT) {
+            fprintf(stderr, "unknown profile %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    memset(port_cnt, 0, sizeof(port_cnt));
+    if (argc == 2) {
+        port_cnt[BUF_SPEED_1G] = 27;
+    } else {
+        for (i = 0; i < BUF_SPEED_CNT; i++) {
+            port_cnt[i] = (uchar) strtoul(argv[2 + i], NULL, 0);
+        }
+    }
+
+    h2_buf_cfg_calc(profile, port_cnt, &cfg);
+
+    printf("Profile %u %s, ports", profile, h2_buf_profile_name(profile));
+    for (i = 0; i < BUF_SPEED_CNT; i++) {
+        printf(" %s: %u", speed_txt[i], port_cnt[i]);
+    }
+    printf("\nShared memory: %lu bytes\n", cfg.shared);
+
+    for (res = 0; res < BUF_RES_CNT; res++) {
+        base = res * 256;
+        printf("\n%s, RES_CFG %u-%u\n", res_txt[res], base, base + 255);
+
+        printf("  q_rsrv   %3u + port*8 + prio:", base + BUF_WM_Q_RSRV);
+        print_wm(res, cfg.q_rsrv[res]);
+        printf("\n");
+
+        for (i = 0; i < BUF_PRIOS; i++) {
+            printf("  prio_shr %3u, prio %u:      ", base + BUF_WM_PRIO_SHR + i, i);
+            print_wm(res, cfg.prio_shr[res][i]);
+            printf("\n");
+        }
+
+        for (i = 0; i < BUF_SPEED_CNT; i++) {
+            printf("  p_rsrv   %3u + port, %-5s:", base + BUF_WM_P_RSRV, speed_txt[i]);
+            print_wm(res, cfg.p_rsrv[res][i]);
+            printf("\n");
+        }
+
+        printf("  col_shr  %3u + dp:          ", base + BUF_WM_COL_SHR);
+        print_wm(res, 0x7ff);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+/*
+ * Model of the Luton26 queue system for the PC build of txrxbench.
+ *
+ * Stands in for the register access of the 8051 (h2_read(), h2_write(),
+ * h2_write_masked()) and models the DEVCPU_QS registers used by the register
+ * based injection and extraction in src/switch/h2txrxaux.c:
+ *
+ *  - INJ_CTRL, INJ_WR and INJ_STATUS of the two injection groups. A frame
+ *    is complete with the word written after EOF, the dummy FCS.
+ *  - The front port loops a complete frame back, as in internal PHY
+ *    loopback, and it is captured to CPU queue cpuq.
+ *  - SYS:SCH:SCH_CPU maps the CPU queue to extraction group 0 or 1. A group
+ *    holds at most depth frames, frames beyond that are dropped.
+ *  - XTR_FRM_PRUNING, XTR_DATA_PRESENT and XTR_RD of the two extraction
+ *    groups, incl. the escaping of data words that look like status words.
+ *
+ * Other registers just keep the value last written. Also provides the few
+ * firmware support functions h2txrxaux.c calls.
+ */
+
+#include "common.h"
+#include "vtss_luton26_regs.h"
+#include "h2io.h"
+#include "h2packet.h"
+#include "misc2.h"
+#include "misc3.h"
+#include "hwport.h"
+#if TRANSIT_LOOPDETECT
+#include "loopdet.h"
+#endif
+#include <string.h>
+#include "qsmodel.h"
+
+/*****************************************************************************
+ *
+ *
+ * Defines
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Extraction status words, see h2txrxaux.c */
+#define XTR_EOF_0           0x80000000UL
+#define XTR_PRUNED          0x80000004UL
+#define XTR_ESCAPE          0x80000006UL
+#define XTR_NOT_READY       0x80000007UL
+
+#define QS_GRP_CNT          2
+#define QS_DEPTH_MAX        32
+#define QS_FRAME_MAX        (RECV_BUFSIZE + 8)
+/* IFH, every data word escaped, status and last word */
+#define QS_WORDS_MAX        (2 + 2 * (QS_FRAME_MAX / 4) + 2)
+#define QS_REG_CNT          16
+
+/*****************************************************************************
+ *
+ *
+ * Typedefs and enums
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* A frame being injected */
+typedef struct {
+    uchar  sof;                         /* SOF seen */
+    uchar  eof;                         /* EOF seen, the FCS word is next */
+    uchar  vld;                         /* Valid bytes in the last data word, 0 for 4 */
+    ushort words;                       /* Words written, incl. the IFH */
+    ulong  word [QS_FRAME_MAX / 4 + 3];  /* Room for the FCS word as well */
+} qs_inj_t;
+
+/* A frame waiting in an extraction group, as the words XTR_RD returns */
+typedef struct {
+    ushort words;
+    ushort next;
+    ulong  word [QS_WORDS_MAX];
+} qs_xtr_t;
+
+typedef struct {
+    uchar    head;
+    uchar    cnt;
+    qs_xtr_t frame [QS_DEPTH_MAX];
+} qs_grp_t;
+
+/*****************************************************************************
+ *
+ *
+ * Local data
+ *
+ *
+ *
+ ****************************************************************************/
+
+ulong xdata h2_access_cnt;
+unsigned char EA;
+
+static uchar    qs_cpuq;
+static uchar    qs_depth;
+static ulong    qs_drop_cnt;
+static ulong    qs_write_val;
+static qs_inj_t qs_inj [QS_GRP_CNT];
+static qs_grp_t qs_grp [QS_GRP_CNT];
+
+static ulong    qs_reg_addr [QS_REG_CNT];
+static ulong    qs_reg_val [QS_REG_CNT];
+static uchar    qs_reg_cnt;
+
+/*****************************************************************************
+ *
+ *
+ * Support functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+/* Plain register, NULL if all are taken */
+static ulong *qs_reg (ulong addr)
+{
+    uchar i;
+
+    for (i = 0; i < qs_reg_cnt; i++) {
+        if (qs_reg_addr[i] == addr) {
+            return &qs_reg_val[i];
+        }
+    }
+    if (qs_reg_cnt == QS_REG_CNT) {
+        return NULL;
+    }
+    qs_reg_addr[qs_reg_cnt] = addr;
+    qs_reg_val[qs_reg_cnt]  = 0;
+    return &qs_reg_val[qs_reg_cnt++];
+}
+
+/* Queue a frame of length bytes incl. FCS from port_no to the CPU */
+static void qs_capture (uchar port_no, const uchar *frame, ushort length)
+{
+    qs_grp_t *grp;
+    qs_xtr_t *xtr;
+    ulong    *reg;
+    ulong    map, word, prune;
+    ushort   words, i;
+    uchar    g;
+
+    reg = qs_reg(VTSS_SYS_SCH_SCH_CPU);
+    map = reg ? VTSS_X_SYS_SCH_SCH_CPU_SCH_CPU_MAP(*reg) : 0;
+    g   = (map >> qs_cpuq) & 1;
+    grp = &qs_grp[g];
+    if (grp->cnt == qs_depth) {
+        qs_drop_cnt++;
+        return;
+    }
+    xtr = &grp->frame[(grp->head + grp->cnt) % QS_DEPTH_MAX];
+    grp->cnt++;
+
+    /* IFH with the source port and the CPU queue mask */
+    xtr->words   = 0;
+    xtr->next    = 0;
+    xtr->word[xtr->words++] = (ulong) port_no << (O_IFH_PORT - 32);
+    xtr->word[xtr->words++] = (ulong) (1 << qs_cpuq) << O_IFH_CPUQ;
+
+    /* PRUNE_SIZE n keeps 4 * n + 4 bytes incl. the IFH */
+    reg   = qs_reg(VTSS_DEVCPU_QS_XTR_XTR_FRM_PRUNING(g));
+    prune = reg ? VTSS_X_DEVCPU_QS_XTR_XTR_FRM_PRUNING_PRUNE_SIZE(*reg) : 0;
+    words = (length + 3) / 4;
+    if (prune && words > prune - 1) {
+        words = prune - 1;
+    } else {
+        prune = 0;
+    }
+
+    for (i = 0; i < words; i++) {
+        word = 0;
+        memcpy(&word, frame + 4 * i, i * 4 + 4 <= length ? 4 : length - i * 4);
+        if (i == words - 1) {
+            /* Status word, then the last data word as is */
+            xtr->word[xtr->words++] = prune ? XTR_PRUNED :
+                                      XTR_EOF_0 + (ushort) (4 * words - length);
+        } else if (word >= XTR_EOF_0 && word <= XTR_NOT_READY) {
+            xtr->word[xtr->words++] = XTR_ESCAPE;
+        }
+        xtr->word[xtr->words++] = word;
+    }
+}
+
+/* Injection register written */
+static BOOL qs_inj_write (ulong addr, ulong value)
+{
+    qs_inj_t *inj;
+    uchar     g;
+    ulong     dest;
+    uchar     port_no;
+    ushort    length;
+
+    for (g = 0; g < QS_GRP_CNT; g++) {
+        inj = &qs_inj[g];
+        if (addr == VTSS_DEVCPU_QS_INJ_INJ_CTRL(g)) {
+            if (value & VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_SOF) {
+                inj->sof   = 1;
+                inj->eof   = 0;
+                inj->words = 0;
+            }
+            if (value & VTSS_F_DEVCPU_QS_INJ_INJ_CTRL_EOF) {
+                inj->eof = 1;
+                inj->vld = VTSS_X_DEVCPU_QS_INJ_INJ_CTRL_VLD_BYTES(value);
+            }
+            return TRUE;
+        }
+        if (addr == VTSS_DEVCPU_QS_INJ_INJ_WR(g)) {
+            if (!inj->sof) {
+                return TRUE;
+            }
+            if (!inj->eof) {
+                if (inj->words < sizeof(inj->word) / 4 - 1) {
+                    inj->word[inj->words++] = value;
+                }
+                return TRUE;
+            }
+
+            /* The FCS word, the frame is complete and loops back on the
+               first port of the IFH DEST mask */
+            inj->sof = 0;
+            if (inj->words < 2 + 15) {
+                return TRUE;
+            }
+            dest = inj->word[0] & VTSS_BITMASK(27);
+            for (port_no = 0; port_no < 27 && !(dest & VTSS_BIT(port_no)); port_no++) {
+            }
+            inj->word[inj->words] = value;
+            length = (inj->words - 2) * 4 - (inj->vld ? 4 - inj->vld : 0);
+            memmove((uchar *) &inj->word[2] + length, &inj->word[inj->words], 4);
+            qs_capture(port_no, (uchar *) &inj->word[2], length + 4);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*****************************************************************************
+ *
+ *
+ * Public functions
+ *
+ *
+ *
+ ****************************************************************************/
+
+void qs_model_init (uchar cpuq, uchar depth)
+{
+    memset(qs_inj, 0, sizeof(qs_inj));
+    memset(qs_grp, 0, sizeof(qs_grp));
+    qs_reg_cnt  = 0;
+    qs_drop_cnt = 0;
+    qs_cpuq     = cpuq;
+    qs_depth    = depth > QS_DEPTH_MAX ? QS_DEPTH_MAX : depth;
+}
+
+ulong qs_model_drop_get (void)
+{
+    return qs_drop_cnt;
+}
+
+ulong h2_read (ulong addr)
+{
+    qs_grp_t *grp;
+    qs_xtr_t *xtr;
+    ulong    *reg;
+    ulong     value;
+    uchar     g;
+
+    if (addr == VTSS_DEVCPU_QS_INJ_INJ_STATUS) {
+        /* Both groups ready, below the watermark */
+        return VTSS_BIT(2) | VTSS_BIT(3);
+    }
+    if (addr == VTSS_DEVCPU_QS_XTR_XTR_DATA_PRESENT) {
+        value = 0;
+        for (g = 0; g < QS_GRP_CNT; g++) {
+            if (qs_grp[g].cnt) {
+                value |= VTSS_BIT(g);
+            }
+        }
+        return value;
+    }
+    for (g = 0; g < QS_GRP_CNT; g++) {
+        if (addr == VTSS_DEVCPU_QS_XTR_XTR_RD(g)) {
+            grp = &qs_grp[g];
+            if (!grp->cnt) {
+                return XTR_NOT_READY;
+            }
+            xtr   = &grp->frame[grp->head];
+            value = xtr->word[xtr->next++];
+            if (xtr->next == xtr->words) {
+                grp->head = (grp->head + 1) % QS_DEPTH_MAX;
+                grp->cnt--;
+            }
+            return value;
+        }
+    }
+    reg = qs_reg(addr);
+    return reg ? *reg : 0;
+}
+
+void h2_write_val (ulong value)
+{
+    qs_write_val = value;
+}
+
+void h2_write_addr (ulong addr)
+{
+    ulong *reg;
+
+    if (!qs_inj_write(addr, qs_write_val)) {
+        reg = qs_reg(addr);
+        if (reg) {
+            *reg = qs_write_val;
+        }
+    }
+}
+
+void h2_write_masked (ulong addr, ulong value, ulong mask)
+{
+    value &= mask;
+    value |= (h2_read(addr) & ~mask);
+    h2_write(addr, value);
+}
+
+/* Firmware support functions used by h2txrxaux.c */
+
+void get_mac_addr (uchar port_no, uchar *mac_addr)
+{
+    static const uchar mac[6] = { 0x00, 0x01, 0xc1, 0x00, 0x00, 0x01 };
+
+    memcpy(mac_addr, mac, sizeof(mac));
+    mac_addr[5] += port_no;
+}
+
+char mac_cmp (uchar xdata *mac_addr_1, uchar xdata *mac_addr_2)
+{
+    return memcmp(mac_addr_1, mac_addr_2, 6) ? 1 : 0;
+}
+
+bit test_bit_32 (uchar bit_no, ulong *src_ptr)
+{
+    return (*src_ptr >> bit_no) & 1;
+}
+
+ulong ushorts2ulong (ushort lsw, ushort msw)
+{
+    return ((ulong) msw << 16) | lsw;
+}
+
+#if TRANSIT_LOOPDETECT
+void ldet_add_cpu_found (vtss_port_no_t i_port_no)
+{
+    i_port_no = i_port_no;
+}
+#endif
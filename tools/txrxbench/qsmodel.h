@@ -0,0 +1,16 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+
+#ifndef __QSMODEL_H__
+#define __QSMODEL_H__
+
+/*
+ * Model of the Luton26 queue system as seen by the register based CPU
+ * injection and extraction of src/switch/h2txrxaux.c, see qsmodel.c.
+ */
+
+void  qs_model_init (uchar cpuq, uchar depth);
+ulong qs_model_drop_get (void);
+
+#endif
@@ -0,0 +1,217 @@
+//Copyright (c) 2004-2020 Microchip Technology Inc. and its subsidiaries.
+//SPDX-License-Identifier: MIT
+
+/*
+ * PC build of the CPU tx/rx benchmark, CLI command "T 3" of the firmware
+ * (perform_tx_rx_bench() in src/switch/txrxtst.c).
+ *
+ * The register based injection and extraction of src/switch/h2txrxaux.c is
+ * built unchanged and run against the model of the queue system in
+ * qsmodel.c. Frames are injected with h2_tx_frame_port(), at most
+ * BENCH_WINDOW ahead, and extracted with h2_rx_frame_get(), once for each
+ * extraction group. For each frame length and group the register accesses
+ * per frame on tx and rx are counted with H2_ACCESS_COUNT() as on the
+ * target, so changes of the tx/rx path can be measured before they reach
+ * the hardware. Frames/s and bytes/s are those of the register accesses
+ * alone at the given time per access; calibrate it with "T 3" on a board.
+ *
+ * Build on a PC, e.g. with gcc:
+ *   S=../../src
+ *   gcc -std=c99 -DTXRXBENCH_HOST -DLOOPBACK_TEST=1 -DLUTON26_L25 \
+ *       -Dxdata= -Dcode= -Didata= -Dsmall= '-Dbit=unsigned char' \
+ *       '-Dsfr=static unsigned char' '-Dsbit=static unsigned char' \
+ *       -I. -I$S/config -I$S/main -I$S/switch -I$S/util -I$S/phy -I$S/cli \
+ *       -I$S/lldp -I$S/loop -I$S/eee -I$S/eee/base/include \
+ *       -I$S/switch/vtss_api/base/luton26 \
+ *       -o txrxbench txrxbench.c qsmodel.c $S/switch/h2txrxaux.c
+ *
+ * Usage:
+ *   txrxbench [-c count] [-a nsec] [-q depth] [-u cpuq] [-p bytes] [-e] [length ...]
+ *
+ *   -c  Frames per length and group, default 1000.
+ *   -a  Time of a register access in nsec, default 1000.
+ *   -q  Frames an extraction group holds, default 16.
+ *   -u  CPU queue the frames are captured to, default 0.
+ *   -p  Prune frames in both extraction groups to bytes, 16-1016.
+ *   -e  Fill the payload with words that must be escaped on extraction.
+ *
+ * The lengths are incl. FCS, BENCH_LENGTH_MIN-BENCH_LENGTH_MAX. Without any,
+ * 64, 128, 256, 512, 1024 and BENCH_LENGTH_MAX are run.
+ */
+
+#include "common.h"
+#include "vtss_luton26_regs.h"
+#include "h2io.h"
+#include "h2packet.h"
+#include "h2txrxaux.h"
+#include "txrxtst.h"
+#include "qsmodel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_PORT          1   /* Chip port looping the frames back */
+#define BENCH_HDR_LENGTH    18  /* DMAC, SMAC, type, subtype and OUI */
+#define BENCH_WINDOW        4   /* Frames injected ahead of extraction, as in txrxtst.c */
+
+/* Same header as build_packet() in txrxtst.c: a slow protocol frame */
+static const uchar bench_hdr [BENCH_HDR_LENGTH] = {
+    0x01, 0x80, 0xc2, 0x00, 0x00, 0x0e,
+    0x00, 0x01, 0xc1, 0x00, 0x00, 0x42,
+    0x88, 0x09, 0x0a, 0x00, 0x01, 0xc1
+};
+
+static const ushort bench_length_def [] = {
+    64, 128, 256, 512, 1024, BENCH_LENGTH_MAX
+};
+
+/* Frame buffer, built in and extracted to as on the target */
+static ulong tx_buf [BENCH_LENGTH_MAX / 4 + 1];
+static ulong rx_buf [BENCH_LENGTH_MAX / 4 + 1];
+
+static void bench_run (ushort length, ushort count, ulong access_ns, BOOL escape)
+{
+    vtss_rx_frame_t rx_frame;
+    uchar           grp;
+    ushort          sent, rcvd, lost, bad, i;
+    ulong           tx_ops, rx_ops, ops, drop;
+    double          ns;
+
+    memset(tx_buf, 0, sizeof(tx_buf));
+    for (i = BENCH_HDR_LENGTH / 4 + 1; i < sizeof(tx_buf) / 4; i++) {
+        tx_buf[i] = escape ? 0x80000006UL : i;
+    }
+    memcpy(tx_buf, bench_hdr, BENCH_HDR_LENGTH);
+    memset(&rx_frame, 0, sizeof(rx_frame));
+    rx_frame.rx_packet = (uchar *) rx_buf;
+
+    for (grp = 0; grp < VTSS_PACKET_RX_GROUP_CNT; grp++) {
+        /* Send all CPU queues to the group under test */
+        H2_WRITE_MASKED(VTSS_SYS_SCH_SCH_CPU,
+                        grp ? VTSS_M_SYS_SCH_SCH_CPU_SCH_CPU_MAP : 0,
+                        VTSS_M_SYS_SCH_SCH_CPU_SCH_CPU_MAP);
+
+        sent   = 0;
+        rcvd   = 0;
+        lost   = 0;
+        bad    = 0;
+        tx_ops = 0;
+        rx_ops = 0;
+        drop   = qs_model_drop_get();
+        while ((ushort) (rcvd + lost) < count) {
+            if (sent < count && (ushort) (sent - rcvd - lost) < BENCH_WINDOW) {
+                ops = h2_access_cnt;
+                if (h2_tx_frame_port(BENCH_PORT, (uchar *) tx_buf, length - 4, VTSS_VID_NULL)) {
+                    sent++;
+                }
+                tx_ops += h2_access_cnt - ops;
+            }
+
+            ops = h2_access_cnt;
+            if (h2_rx_frame_get(grp, &rx_frame)) {
+                if (rx_frame.header.port == BENCH_PORT) {
+                    /* A frame dropped on extraction is lost, not received */
+                    if (rx_frame.discard) {
+                        bad++;
+                    } else {
+                        rcvd++;
+                    }
+                }
+            } else {
+                /* The model never holds a frame back, the rest was dropped */
+                lost = qs_model_drop_get() - drop + bad;
+                if (sent == (ushort) (rcvd + lost) && sent < count && !lost) {
+                    break; /* Injection is stuck */
+                }
+            }
+            rx_ops += h2_access_cnt - ops;
+        }
+
+        ns = (double) (tx_ops + rx_ops) * access_ns;
+        printf("%6u  %3u %7u %5u %7u %7u %9.0f %10.0f %7u\n",
+               length, grp, rcvd, lost,
+               sent ? (unsigned) (tx_ops / sent) : 0,
+               rcvd ? (unsigned) (rx_ops / rcvd) : 0,
+               ns ? rcvd * 1e9 / ns : 0,
+               ns ? rcvd * 1e9 / ns * length : 0,
+               (unsigned) h2_rx_class_cnt_get(RX_CLASS_CNT + 1));
+        h2_rx_class_cnt_clear();
+    }
+}
+
+int main (int argc, char **argv)
+{
+    ushort count = 1000;
+    ulong  access_ns = 1000;
+    ulong  prune = 0;
+    uchar  depth = 16;
+    uchar  cpuq = 0;
+    BOOL   escape = FALSE;
+    ushort length;
+    uchar  grp;
+    int    arg;
+    int    i;
+
+    for (arg = 1; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-e") == 0) {
+            escape = TRUE;
+            continue;
+        }
+        if (argv[arg][1] == 0 || argv[arg][2] != 0 || arg + 1 == argc) {
+            break;
+        }
+        switch (argv[arg++][1]) {
+        case 'c':
+            count = (ushort) strtoul(argv[arg], NULL, 0);
+            continue;
+        case 'a':
+            access_ns = (ulong) strtoul(argv[arg], NULL, 0);
+            continue;
+        case 'q':
+            depth = (uchar) strtoul(argv[arg], NULL, 0);
+            continue;
+        case 'u':
+            cpuq = (uchar) strtoul(argv[arg], NULL, 0) & 7;
+            continue;
+        case 'p':
+            prune = (ulong) strtoul(argv[arg], NULL, 0);
+            if (prune < 16 || prune > 1016) {
+                fprintf(stderr, "prune size must be in range 16-1016\n");
+                return 1;
+            }
+            continue;
+        }
+        arg--;
+        break;
+    }
+    if (arg < argc && argv[arg][0] == '-') {
+        fprintf(stderr, "usage: %s [-c count] [-a nsec] [-q depth] [-u cpuq] "
+                "[-p bytes] [-e] [length ...]\n", argv[0]);
+        return 1;
+    }
+
+    qs_model_init(cpuq, depth);
+    for (grp = 0; grp < VTSS_PACKET_RX_GROUP_CNT; grp++) {
+        /* As h2_rx_grp_conf(): PRUNE_SIZE n keeps 4 * n + 4 bytes incl. the IFH */
+        H2_WRITE(VTSS_DEVCPU_QS_XTR_XTR_FRM_PRUNING(grp),
+                 VTSS_F_DEVCPU_QS_XTR_XTR_FRM_PRUNING_PRUNE_SIZE(prune ? (prune + 7) / 4 : 0));
+    }
+
+    printf("Register access %u nsec, group depth %u, CPU queue %u\n",
+           (unsigned) access_ns, depth, cpuq);
+    printf("Length  Grp  Frames  Lost  Tx ops  Rx ops  Frames/s    Bytes/s  Pruned\n");
+    if (arg == argc) {
+        for (i = 0; i < (int) (sizeof(bench_length_def) / sizeof(bench_length_def[0])); i++) {
+            bench_run(bench_length_def[i], count, access_ns, escape);
+        }
+    }
+    for (; arg < argc; arg++) {
+        length = (ushort) strtoul(argv[arg], NULL, 0);
+        if (length < BENCH_LENGTH_MIN || length > BENCH_LENGTH_MAX) {
+            fprintf(stderr, "length must be in range %u-%u\n", BENCH_LENGTH_MIN, BENCH_LENGTH_MAX);
+            return 1;
+        }
+        bench_run(length, count, access_ns, escape);
+    }
+    return 0;
+}